@@ -0,0 +1,141 @@
+/**
+ * Engine adapter producing antithetic streams
+ *
+ * @file AntitheticEngine.h
+ */
+
+#ifndef ANTITHETICENGINE_H_
+#define ANTITHETICENGINE_H_
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <stdint.h>
+#include "serialize.h"
+
+namespace myrng
+{
+
+/**
+ * Engine adapter that can mirror the output of @p Engine.
+ *
+ * In antithetic mode every raw number y is replaced by its complement
+ * max() - y, and canonical() maps y and max() - y exactly to U and 1 - U.
+ * A run with the same seed in antithetic mode thus draws 1 - U wherever the
+ * normal run draws U, and all methods of RandomVariates that transform
+ * uniforms monotonically produce antithetic variates: Exponential() gives
+ * -m log(1 - U) instead of -m log(U), and the polar method of
+ * Normal01Polar() and GaussianPolar() gives exactly -Z instead of Z. The
+ * average of a pair of runs has a smaller variance than the average of two
+ * independent runs whenever the result depends monotonically on the
+ * random input.
+ *
+ * Whole runs are mirrored rather than alternate numbers, because methods
+ * that draw several uniforms per variate would otherwise combine U with
+ * 1 - U. Example:
+ * @code
+ * myrng::RandomVariates<myrng::AntitheticEngine<myrng::WELLEngine> > rng;
+ * rng.Seed(run);
+ * const double a = simulate(rng);
+ * rng.setAntithetic(true);
+ * rng.Seed(run);
+ * const double b = simulate(rng); // the antithetic run
+ * estimate += (a + b) / 2;
+ * @endcode
+ * @tparam Engine random number generator engine with min() = 0 and max() =
+ * 2^32 - 1 or 2^64 - 1
+ */
+template<class Engine>
+class AntitheticEngine: public Engine
+{
+public:
+	typedef typename Engine::result_type result_type;
+
+	AntitheticEngine() :
+			antithetic(false)
+	{
+		static_assert(Engine::min() == 0 && (Engine::max() == 0xffffffffU
+				|| Engine::max() == 0xffffffffffffffffULL),
+				"Engine has to produce all 32 or 64 bits");
+	}
+	/**
+	 * Switch between the normal and the antithetic stream.
+	 *
+	 * Reseed afterwards to obtain the antithetic stream of a run.
+	 */
+	void setAntithetic(bool a)
+	{
+		antithetic = a;
+	}
+	/**
+	 * Check whether the numbers are mirrored
+	 */
+	bool isAntithetic() const
+	{
+		return antithetic;
+	}
+	/// Produce a raw random number, mirrored in antithetic mode.
+	result_type operator()()
+	{
+		const result_type y = Engine::operator()();
+		return antithetic ? static_cast<result_type>(~y) : y;
+	}
+	/// Produce @p n raw numbers into @p out, mirrored in antithetic mode.
+	void fill(result_type* out, std::size_t n)
+	{
+		Engine::fill(out, n);
+		if (antithetic)
+			for (std::size_t i = 0; i < n; ++i)
+				out[i] = static_cast<result_type>(~out[i]);
+	}
+	/**
+	 * Convert a raw random number to a double on the interval (0,1).
+	 *
+	 * Maps to the centre of the interval of the raw number, which makes
+	 * canonical(max() - y) = 1 - canonical(y) exact. 64-bit numbers are
+	 * truncated to their upper 52 bits, so that the centre is representable.
+	 */
+	static double canonical(result_type y)
+	{
+		if (sizeof(result_type) == 4)
+			return (y + 0.5) * (1.0 / 4294967296.0);
+		return ((y >> (DIGITS > 52 ? DIGITS - 52 : 0)) + 0.5)
+				* (1.0 / 4503599627370496.0);
+	}
+	/**
+	 * Write the complete generator state to @p os.
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		Engine::save(os);
+		serialize::writeUInt(os, antithetic, 1);
+		return os;
+	}
+	/**
+	 * Restore a generator state written by save().
+	 *
+	 * On error the failbit of @p is is set.
+	 */
+	std::istream& load(std::istream& is)
+	{
+		uint64_t a;
+		if (!Engine::load(is) || !serialize::readUInt(is, a, 1) || a > 1)
+			return serialize::fail(is);
+		antithetic = a != 0;
+		return is;
+	}
+
+protected:
+	~AntitheticEngine()
+	{
+	}
+
+private:
+	/// Number of bits of a raw number
+	static const unsigned int DIGITS = 8 * sizeof(result_type);
+
+	bool antithetic; ///< mirror the numbers
+};
+
+} /* namespace myrng */
+#endif /* ANTITHETICENGINE_H_ */
@@ -0,0 +1,290 @@
+#include "AnyEngine.h"
+#include "WELLEngine.h"
+#include "MTEngine.h"
+
+namespace myrng
+{
+
+/**
+ * Virtual interface of the engines behind AnyEngine.
+ *
+ * All methods work on 32-bit numbers, so fill() and discard() count the
+ * halves of 64-bit numbers.
+ */
+class AnyEngine::Model
+{
+public:
+	virtual ~Model()
+	{
+	}
+	virtual Model* clone() const = 0;
+	virtual void seed(unsigned long int s) = 0;
+	virtual unsigned long int getSeed() const = 0;
+	virtual const char* getName() const = 0;
+	/// Offset of the conversion to double, see AnyEngine::canonical()
+	virtual double offset() const = 0;
+	/// Write @p n raw numbers to @p out, @p n has to be even
+	virtual void fill(result_type* out, std::size_t n) = 0;
+	/// Skip @p z raw numbers, @p z has to be even
+	virtual void discard(unsigned long long z) = 0;
+	virtual std::ostream& save(std::ostream& os) const = 0;
+	virtual std::istream& load(std::istream& is) = 0;
+};
+
+namespace
+{
+
+#ifdef MYRNG_HAVE_TARGET_CLONES
+/**
+ * Compile a kernel for AVX-512, AVX2 and the baseline instruction set of
+ * the target, e.g. SSE2 on x86-64. The dynamic loader selects the version
+ * for the CPU the library runs on, and everything the kernel calls is
+ * inlined into each version.
+ */
+#define MYRNG_DISPATCH \
+	__attribute__((flatten, target_clones("avx512f", "avx2", "default")))
+#else
+#define MYRNG_DISPATCH
+#endif
+
+/**
+ * Write @p n raw numbers of @p engine to @p out, @p n has to be even.
+ *
+ * 64-bit numbers are split into two halves, the lower one first. The block
+ * generation of the Mersenne Twister engines is vectorised in the versions
+ * for the wider instruction sets.
+ */
+template<class Engine>
+MYRNG_DISPATCH
+void fillHalves(Engine& engine, AnyEngine::result_type* out, std::size_t n)
+{
+	typedef typename Engine::result_type word_type;
+	if (sizeof(word_type) == sizeof(AnyEngine::result_type))
+	{
+		engine.fill(reinterpret_cast<word_type*>(out), n);
+		return;
+	}
+	word_type block[256];
+	for (std::size_t i = 0; i < n; i += 512)
+	{
+		const std::size_t m = n - i < 512 ? (n - i) / 2 : 256;
+		engine.fill(block, m);
+		for (std::size_t k = 0; k < m; ++k)
+		{
+			out[i + 2 * k] = static_cast<AnyEngine::result_type>(block[k]);
+			out[i + 2 * k + 1] = static_cast<AnyEngine::result_type>(
+					block[k] >> 16 >> 16);
+		}
+	}
+}
+
+/// The engine @p Engine behind the interface of AnyEngine
+template<class Engine>
+class EngineModel: public AnyEngine::Model, public Engine
+{
+public:
+	typedef typename Engine::result_type word_type;
+	/// Number of 32-bit halves of a raw number of the engine
+	static const std::size_t HALVES = sizeof(word_type) / 4;
+
+	Model* clone() const
+	{
+		return new EngineModel(*this);
+	}
+	void seed(unsigned long int s)
+	{
+		Engine::seed(s);
+	}
+	unsigned long int getSeed() const
+	{
+		return Engine::getSeed();
+	}
+	const char* getName() const
+	{
+		return Engine::getName();
+	}
+	double offset() const
+	{
+		// WELL engines map 0 to 0, MT engines to the middle of the first
+		// interval
+		return Engine::canonical(0) > 0 ? 0.5 : 0.;
+	}
+	void fill(AnyEngine::result_type* out, std::size_t n)
+	{
+		fillHalves<Engine>(*this, out, n);
+	}
+	void discard(unsigned long long z)
+	{
+		Engine::discard(z / HALVES);
+	}
+	std::ostream& save(std::ostream& os) const
+	{
+		return Engine::save(os);
+	}
+	std::istream& load(std::istream& is)
+	{
+		return Engine::load(is);
+	}
+};
+
+/// Create the engine called @p name, or return 0 if it does not exist
+AnyEngine::Model* create(const std::string& name)
+{
+	AnyEngine::Model* m = 0;
+	if (name == WELL512aParams::name())
+		m = new EngineModel<WELL512Engine>;
+	else if (name == WELL1024aParams::name())
+		m = new EngineModel<WELLEngine>;
+	else if (name == WELL19937aParams::name())
+		m = new EngineModel<WELL19937Engine>;
+	else if (name == WELL44497aParams::name())
+		m = new EngineModel<WELL44497Engine>;
+	else if (name == MT11213Params::name())
+		m = new EngineModel<MT11213Engine>;
+	else if (name == MT19937Params::name())
+		m = new EngineModel<MTEngine>;
+	else if (name == MT19937_64Params::name())
+		m = new EngineModel<MT19937_64Engine>;
+	return m;
+}
+
+} /* namespace */
+
+const std::size_t AnyEngine::BUFFER;
+
+AnyEngine::AnyEngine() :
+		model(0), offset(0.), pos(BUFFER), refills_(0)
+{
+	reset(create(WELL1024aParams::name()));
+}
+
+AnyEngine::AnyEngine(const AnyEngine& other) :
+		model(other.model->clone()), offset(other.offset), pos(other.pos),
+		refills_(other.refills_)
+{
+	for (std::size_t i = 0; i < BUFFER; ++i)
+		buffer[i] = other.buffer[i];
+}
+
+AnyEngine& AnyEngine::operator=(const AnyEngine& other)
+{
+	if (this != &other)
+	{
+		reset(other.model->clone());
+		pos = other.pos;
+		refills_ = other.refills_;
+		for (std::size_t i = 0; i < BUFFER; ++i)
+			buffer[i] = other.buffer[i];
+	}
+	return *this;
+}
+
+AnyEngine::~AnyEngine()
+{
+	delete model;
+}
+
+bool AnyEngine::select(const std::string& name)
+{
+	Model* m = create(name);
+	if (!m)
+		return false;
+	m->seed(model->getSeed());
+	reset(m);
+	return true;
+}
+
+std::vector<std::string> AnyEngine::names()
+{
+	std::vector<std::string> n;
+	n.push_back(WELL512aParams::name());
+	n.push_back(WELL1024aParams::name());
+	n.push_back(WELL19937aParams::name());
+	n.push_back(WELL44497aParams::name());
+	n.push_back(MT11213Params::name());
+	n.push_back(MT19937Params::name());
+	n.push_back(MT19937_64Params::name());
+	return n;
+}
+
+void AnyEngine::seed(unsigned long int s)
+{
+	model->seed(s);
+	pos = BUFFER;
+}
+
+unsigned long int AnyEngine::getSeed() const
+{
+	return model->getSeed();
+}
+
+const char* AnyEngine::getName() const
+{
+	return model->getName();
+}
+
+void AnyEngine::discard(unsigned long long z)
+{
+	if (z <= BUFFER - pos)
+	{
+		pos += z;
+		return;
+	}
+	z -= BUFFER - pos;
+	// skip whole buffers in the engine, then the rest in the buffer
+	model->discard(z / BUFFER * BUFFER);
+	refill();
+	pos = z % BUFFER;
+}
+
+std::ostream& AnyEngine::save(std::ostream& os) const
+{
+	serialize::writeTag(os, getName());
+	serialize::write32(os, pos);
+	for (std::size_t i = pos; i < BUFFER; ++i)
+		serialize::write32(os, buffer[i]);
+	return model->save(os);
+}
+
+std::istream& AnyEngine::load(std::istream& is)
+{
+	std::string name;
+	std::size_t p;
+	if (!serialize::readTag(is, name) || !serialize::read32(is, p)
+			|| p > BUFFER)
+		return serialize::fail(is);
+	result_type b[BUFFER];
+	for (std::size_t i = p; i < BUFFER; ++i)
+		if (!serialize::read32(is, b[i]))
+			return serialize::fail(is);
+	Model* m = create(name);
+	if (!m)
+		return serialize::fail(is);
+	if (!m->load(is))
+	{
+		delete m;
+		return is;
+	}
+	reset(m);
+	pos = p;
+	for (std::size_t i = p; i < BUFFER; ++i)
+		buffer[i] = b[i];
+	return is;
+}
+
+void AnyEngine::refill()
+{
+	model->fill(buffer, BUFFER);
+	pos = 0;
+	++refills_;
+}
+
+void AnyEngine::reset(Model* m)
+{
+	delete model;
+	model = m;
+	offset = m->offset();
+	pos = BUFFER;
+}
+
+} /* namespace myrng */
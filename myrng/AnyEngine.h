@@ -0,0 +1,170 @@
+/**
+ * Engine selected at run time
+ *
+ * @file AnyEngine.h
+ */
+
+#ifndef ANYENGINE_H_
+#define ANYENGINE_H_
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "RandomVariates.h"
+
+namespace myrng
+{
+
+/**
+ * Random number generator engine whose algorithm is chosen at run time.
+ *
+ * The engine is selected by its name, e.g. from a configuration file, among
+ * the engines listed by names(): all WELL and Mersenne Twister variants of
+ * this library. The implementations are compiled into the shared library
+ * libmyrng, so a program linked against it can compare all of them without
+ * being rebuilt.
+ *
+ * The selected engine is called through a virtual interface, but only once
+ * per BUFFER raw numbers: each call fills the internal buffer of 4 kB, from
+ * which operator()() serves the numbers inline. The overhead of the
+ * dispatch is thus negligible, and RandomVariates<AnyEngine> yields exactly
+ * the same variates as RandomVariates with the selected engine itself. The
+ * only exception is MT19937-64, whose 64-bit numbers are delivered as two
+ * 32-bit halves, the lower one first.
+ * Example:
+ * @code
+ * #include <AnyEngine.h>
+ * myrng::AnyRNG rng;
+ * if (!rng.select(config.engine))
+ *     error("unknown engine");
+ * rng.Seed(config.seed);
+ * double x = rng.Normal01Polar();
+ * @endcode
+ * Link with -lmyrng-VERSION, see the pkg-config file myrng.pc.
+ */
+class AnyEngine
+{
+public:
+	/// Type of the raw random numbers
+	typedef uint32_t result_type;
+
+	/// Number of raw numbers generated per call of the selected engine
+	static const std::size_t BUFFER = 1024;
+
+	/**
+	 * Constructor, selects WELL1024a
+	 */
+	AnyEngine();
+	AnyEngine(const AnyEngine& other);
+	AnyEngine& operator=(const AnyEngine& other);
+
+	/**
+	 * Select the engine called @p name.
+	 *
+	 * The new engine is seeded with the current seed. If there is no engine
+	 * of that name, the current engine is kept.
+	 * @return false if @p name is unknown
+	 */
+	bool select(const std::string& name);
+	/**
+	 * Get the names of all engines that can be selected
+	 */
+	static std::vector<std::string> names();
+	/**
+	 * Set random number generator seed
+	 */
+	void seed(unsigned long int s);
+	/**
+	 * Get random number generator seed
+	 */
+	unsigned long int getSeed() const;
+	/**
+	 * Get the name of the selected engine
+	 */
+	const char* getName() const;
+	/**
+	 * Smallest raw random number
+	 */
+	static constexpr result_type min()
+	{
+		return 0;
+	}
+	/**
+	 * Largest raw random number
+	 */
+	static constexpr result_type max()
+	{
+		return 0xffffffffU;
+	}
+	/**
+	 * Produce a raw random number.
+	 */
+	result_type operator()()
+	{
+		if (pos == BUFFER)
+			refill();
+		return buffer[pos++];
+	}
+	/**
+	 * Convert a raw random number to a double as the selected engine does,
+	 * i.e. on [0,1) for WELL and on (0,1) for Mersenne Twister engines.
+	 */
+	double canonical(result_type y) const
+	{
+		return (y + offset) * (1.0 / 4294967296.0);
+	}
+	/**
+	 * Advance the state by @p z steps, see BasicWELLEngine::discard().
+	 */
+	void discard(unsigned long long z);
+	/**
+	 * Get the number of calls of the selected engine.
+	 *
+	 * Counted even without -DMYRNG_STATS, so that the layout of the class
+	 * does not depend on the flag the library was compiled with.
+	 */
+	unsigned long long getRefills() const
+	{
+		return refills_;
+	}
+	/**
+	 * Write the complete state to @p os.
+	 *
+	 * Saves the name and state of the selected engine together with the
+	 * numbers left in the buffer.
+	 */
+	std::ostream& save(std::ostream& os) const;
+	/**
+	 * Restore a state written by save(), selecting the saved engine.
+	 *
+	 * On error the failbit of @p is is set and the state is left unchanged.
+	 */
+	std::istream& load(std::istream& is);
+
+	/// Interface of the selected engine, defined in AnyEngine.cpp
+	class Model;
+
+protected:
+	~AnyEngine();
+
+private:
+	Model* model; ///< the selected engine
+	double offset; ///< added to a raw number by canonical()
+	std::size_t pos; ///< index of the next number in buffer
+	result_type buffer[BUFFER];
+	unsigned long long refills_; ///< number of calls of the engine
+
+	/// Fill the buffer from the selected engine
+	void refill();
+	/// Replace the selected engine by @p m
+	void reset(Model* m);
+};
+
+/// Random variates from an engine selected at run time.
+typedef RandomVariates<AnyEngine> AnyRNG;
+
+} /* namespace myrng */
+#endif /* ANYENGINE_H_ */
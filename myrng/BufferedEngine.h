@@ -0,0 +1,271 @@
+/**
+ * Engine adapter generating numbers ahead of demand in a background thread
+ *
+ * @file BufferedEngine.h
+ */
+
+#ifndef BUFFEREDENGINE_H_
+#define BUFFEREDENGINE_H_
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "serialize.h"
+
+namespace myrng
+{
+
+/**
+ * Engine adapter that moves random number generation into a background
+ * thread.
+ *
+ * A producer thread keeps a single-producer/single-consumer ring buffer of
+ * @p Size raw numbers filled with the output of @p Engine. Drawing a number
+ * only reads the next buffer slot without locking, so the cost of the
+ * generator, including e.g. the regeneration of the MT19937 state, is taken
+ * off the critical path of a single-threaded simulation. The sequence of
+ * numbers is the same as that of @p Engine with the same seed.
+ *
+ * The producer sleeps on a condition variable while the buffer is full and
+ * is woken once the consumer has made room for a batch of Size / 8 numbers.
+ * The consumer only sleeps if it finds the buffer empty. Neither side spins,
+ * so a BufferedEngine occupies a second core only while it generates.
+ *
+ * @p Engine is a private base: only the members that are safe to call while
+ * the producer runs are available, and they lock the engine.
+ *
+ * The consumer side is not thread-safe: a BufferedEngine must be used by a
+ * single thread. Programs using it have to be compiled with -pthread.
+ * Example:
+ * @code
+ * myrng::RandomVariates<myrng::BufferedEngine<myrng::MTEngine> > rng;
+ * rng.Seed(42);
+ * double u = rng.Uniform01(); // same value as with myrng::MT19937
+ * @endcode
+ *
+ * @tparam Engine random number generator engine
+ * @tparam Size capacity of the ring buffer, has to be a power of two
+ */
+template<class Engine, std::size_t Size = 4096>
+class BufferedEngine: private Engine
+{
+public:
+	typedef typename Engine::result_type result_type;
+
+	using Engine::getSeed;
+	using Engine::getName;
+	using Engine::min;
+	using Engine::max;
+	using Engine::canonical;
+
+	BufferedEngine() :
+			head(0), tail(0), headCache(0), sleeping(false), running(true),
+			starving(false)
+	{
+		static_assert(Size >= 16 && (Size & (Size - 1)) == 0,
+				"Size has to be a power of two");
+		producer = std::thread(&BufferedEngine::produce, this);
+	}
+	/**
+	 * Set random number generator seed
+	 *
+	 * Discards the numbers generated ahead.
+	 */
+	void seed(unsigned long int s)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Engine::seed(s);
+		clear();
+	}
+	/**
+	 * Skip the next @p z raw numbers.
+	 *
+	 * Numbers generated ahead are skipped first, the rest is skipped by the
+	 * engine.
+	 */
+	void discard(unsigned long long z)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::size_t h = head.load(std::memory_order_relaxed);
+		std::size_t t = tail.load(std::memory_order_relaxed);
+		if (z < h - t)
+		{
+			tail.store(t + z, std::memory_order_release);
+			drained.notify_one();
+			return;
+		}
+		Engine::discard(z - (h - t));
+		clear();
+	}
+	/**
+	 * Get the number of regenerations of the engine state, including those
+	 * for numbers generated ahead.
+	 */
+	unsigned long long getRefills() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return Engine::getRefills();
+	}
+	/**
+	 * Write the complete generator state to @p os.
+	 *
+	 * Saves the state of @p Engine together with the numbers generated ahead
+	 * but not yet consumed.
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::size_t h = head.load(std::memory_order_relaxed);
+		std::size_t t = tail.load(std::memory_order_relaxed);
+		Engine::save(os);
+		serialize::write32(os, h - t);
+		for (; t != h; ++t)
+			serialize::writeUInt(os, buf[t & (Size - 1)],
+					sizeof(result_type));
+		return os;
+	}
+	/**
+	 * Restore a generator state written by save().
+	 *
+	 * On error the failbit of @p is is set.
+	 */
+	std::istream& load(std::istream& is)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::size_t n;
+		uint64_t x;
+		if (!Engine::load(is) || !serialize::read32(is, n) || n > Size)
+			return serialize::fail(is);
+		clear();
+		std::size_t t = tail.load(std::memory_order_relaxed);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			if (!serialize::readUInt(is, x, sizeof(result_type)))
+				return serialize::fail(is);
+			buf[(t + i) & (Size - 1)] = static_cast<result_type>(x);
+		}
+		head.store(t + n, std::memory_order_release);
+		headCache = t + n;
+		return is;
+	}
+	/// Take the next raw number from the buffer.
+	result_type operator()()
+	{
+		std::size_t t = tail.load(std::memory_order_relaxed);
+		if (t == headCache
+				&& (headCache = head.load(std::memory_order_acquire)) == t)
+			waitFilled(t);
+		result_type x = buf[t & (Size - 1)];
+		tail.store(t + 1, std::memory_order_release);
+		if (((t + 1) & (BATCH - 1)) == 0)
+		{
+			// pairs with the fence in produce(): either the producer sees
+			// the new tail or we see that it sleeps
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (sleeping.load(std::memory_order_relaxed))
+				wake();
+		}
+		return x;
+	}
+
+protected:
+	~BufferedEngine()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			running = false;
+			drained.notify_one();
+		}
+		producer.join();
+	}
+
+private:
+	BufferedEngine(const BufferedEngine&);
+	BufferedEngine& operator=(const BufferedEngine&);
+
+	enum
+	{
+		BATCH = Size / 8 ///< numbers generated per lock of the engine
+	};
+
+	/// Number of free slots in the buffer
+	std::size_t space() const
+	{
+		return Size - (head.load(std::memory_order_relaxed)
+				- tail.load(std::memory_order_acquire));
+	}
+
+	/// Empty the buffer. Must be called with the mutex held.
+	void clear()
+	{
+		std::size_t t = tail.load(std::memory_order_relaxed);
+		head.store(t, std::memory_order_release);
+		headCache = t;
+		drained.notify_one();
+	}
+
+	/// Wake the producer sleeping on a full buffer
+	void wake()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		drained.notify_one();
+	}
+
+	/// Sleep until the producer has stored the number after count @p t
+	void waitFilled(std::size_t t)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (sleeping.load(std::memory_order_relaxed))
+			drained.notify_one();
+		starving = true;
+		while ((headCache = head.load(std::memory_order_relaxed)) == t)
+			filled.wait(lock);
+		starving = false;
+	}
+
+	/// Body of the producer thread
+	void produce()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (running)
+		{
+			if (space() < BATCH)
+			{
+				sleeping.store(true, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				while (running && space() < BATCH)
+					drained.wait(lock);
+				sleeping.store(false, std::memory_order_relaxed);
+				continue;
+			}
+			std::size_t h = head.load(std::memory_order_relaxed);
+			for (std::size_t i = 0; i < BATCH; ++i)
+				buf[(h + i) & (Size - 1)] = Engine::operator()();
+			head.store(h + BATCH, std::memory_order_release);
+			if (starving)
+				filled.notify_one();
+			// let seed(), save() and load() of the consumer in
+			lock.unlock();
+			lock.lock();
+		}
+	}
+
+	result_type buf[Size]; ///< ring buffer
+	alignas(64) std::atomic<std::size_t> head; ///< count of numbers produced
+	alignas(64) std::atomic<std::size_t> tail; ///< count of numbers consumed
+	std::size_t headCache; ///< last value of head seen by the consumer
+	alignas(64) std::atomic<bool> sleeping; ///< the producer waits for room
+	bool running; ///< false stops the producer, guarded by mutex
+	bool starving; ///< the consumer waits for numbers, guarded by mutex
+	mutable std::mutex mutex; ///< protects the engine state
+	std::condition_variable drained; ///< room in the buffer, or stop
+	std::condition_variable filled; ///< numbers in the buffer
+	std::thread producer; ///< background thread filling the buffer
+};
+
+} /* namespace myrng */
+#endif /* BUFFEREDENGINE_H_ */
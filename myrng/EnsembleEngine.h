@@ -0,0 +1,219 @@
+/**
+ * Multi-lane WELL engine for ensembles of replicas
+ *
+ * @file EnsembleEngine.h
+ */
+
+#ifndef ENSEMBLEENGINE_H_
+#define ENSEMBLEENGINE_H_
+
+#include <cstddef>
+#include <ctime>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+#include "WELLEngine.h"
+#include "serialize.h"
+#include "util.h"
+
+namespace myrng
+{
+
+/**
+ * @p Lanes independent WELL generators advanced in lock-step.
+ *
+ * The states of all lanes are stored in structure-of-arrays layout: word
+ * @c i of the state of every lane is kept in one contiguous row. One step
+ * of the recurrence applies the same shifts and masks to all lanes, so the
+ * compiler turns the loop over the lanes into a few vector instructions,
+ * and the whole ensemble shares a few cache lines per step instead of one
+ * scattered state per replica.
+ *
+ * Each call of next() advances all lanes by one step and returns one raw
+ * number per lane. Lane @c k produces exactly the same sequence as a
+ * BasicWELLEngine<Params> seeded with laneSeed(s, k), so any replica can be
+ * rerun on its own with a scalar generator.
+ * Use it through EnsembleVariates:
+ * @code
+ * myrng::EnsembleVariates<myrng::WELLEnsembleEngine<16> > rng;
+ * double u[16];
+ * rng.Seed(42);
+ * rng.Uniform01(u); // one number per replica
+ * @endcode
+ *
+ * @tparam Params parameters of the WELL generator, e.g. WELL1024aParams
+ * @tparam Lanes number of independent generators
+ */
+template<class Params, std::size_t Lanes>
+class BasicWELLEnsembleEngine
+{
+public:
+	/// Type of the raw random numbers
+	typedef uint32_t result_type;
+
+	BasicWELLEnsembleEngine()
+	{
+		state_i = 0;
+		seed((unsigned long) std::time(0));
+	}
+	/**
+	 * Set random number generator seed
+	 *
+	 * Lane @c k is seeded with laneSeed(@p s, k).
+	 */
+	void seed(unsigned long int s)
+	{
+		seed_ = s;
+		state_i = 0;
+		for (std::size_t k = 0; k < Lanes; ++k)
+			STATE[0][k] = static_cast<uint32_t>(laneSeed(s, k));
+		for (unsigned int i = 1; i < R; ++i)
+			for (std::size_t k = 0; k < Lanes; ++k)
+				STATE[i][k] = 1812433253U
+						* (STATE[i - 1][k] ^ (STATE[i - 1][k] >> 30)) + i;
+		for (int j = 0; j < 10000; ++j)
+			next();
+	}
+	/**
+	 * Get random number generator seed
+	 */
+	unsigned long int getSeed() const
+	{
+		return seed_;
+	}
+	/**
+	 * Get the name of the random number generator engine
+	 */
+	static const char* getName()
+	{
+		return Params::name();
+	}
+	/**
+	 * Get the seed of the scalar generator equivalent to lane @p k
+	 */
+	static unsigned long int laneSeed(unsigned long int s, std::size_t k)
+	{
+		return static_cast<unsigned long int>(util::splitmix64(
+				util::splitmix64(s) + k) & 0xffffffffUL);
+	}
+	/**
+	 * Get the number of lanes
+	 */
+	static constexpr std::size_t lanes()
+	{
+		return Lanes;
+	}
+	/**
+	 * Advance all lanes by one step.
+	 *
+	 * @return pointer to @p Lanes raw numbers, one per lane, valid until
+	 * the next call
+	 */
+	const result_type* next()
+	{
+		uint32_t* V0 = STATE[state_i];
+		const uint32_t* VM1 = STATE[mod(state_i + M1)];
+		const uint32_t* VM2 = STATE[mod(state_i + M2)];
+		const uint32_t* VM3 = STATE[mod(state_i + M3)];
+		const uint32_t* VRm2 = STATE[mod(state_i + R - 2)];
+		state_i = mod(state_i + R - 1);
+		uint32_t* VRm1 = STATE[state_i];
+		for (std::size_t k = 0; k < Lanes; ++k)
+		{
+			// the generic WELL recurrence, see BasicWELLEngine
+			uint32_t z0, z1, z2, z3;
+			if (P == 0)
+				z0 = VRm1[k];
+			else
+				z0 = (VRm1[k] & MASKL) | (VRm2[k] & MASKU);
+			z1 = Params::T0(V0[k]) ^ Params::T1(VM1[k]);
+			z2 = Params::T2(VM2[k]) ^ Params::T3(VM3[k]);
+			z3 = z1 ^ z2;
+			V0[k] = z3;
+			VRm1[k] = Params::T4(z0) ^ Params::T5(z1) ^ Params::T6(z2)
+					^ Params::T7(z3);
+		}
+		return VRm1;
+	}
+	/**
+	 * Convert a raw random number to a double on the interval [0,1).
+	 */
+	static double canonical(result_type y)
+	{
+		return BasicWELLEngine<Params>::canonical(y);
+	}
+	/**
+	 * Write the complete generator state to @p os.
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		serialize::writeTag(os, getName());
+		serialize::write32(os, Lanes);
+		serialize::write64(os, seed_);
+		serialize::write32(os, state_i);
+		for (unsigned int i = 0; i < R; ++i)
+			for (std::size_t k = 0; k < Lanes; ++k)
+				serialize::write32(os, STATE[i][k]);
+		return os;
+	}
+	/**
+	 * Restore a generator state written by save().
+	 *
+	 * On error the failbit of @p is is set and the state is left unchanged.
+	 */
+	std::istream& load(std::istream& is)
+	{
+		std::size_t lanes;
+		unsigned long int s;
+		unsigned int i;
+		if (!serialize::readTag(is, getName()) || !serialize::read32(is, lanes)
+				|| lanes != Lanes || !serialize::read64(is, s)
+				|| !serialize::read32(is, i) || i >= R)
+			return serialize::fail(is);
+		std::vector<uint32_t> state(R * Lanes);
+		for (std::size_t k = 0; k < R * Lanes; ++k)
+			if (!serialize::read32(is, state[k]))
+				return serialize::fail(is);
+		seed_ = s;
+		state_i = i;
+		for (unsigned int r = 0; r < R; ++r)
+			for (std::size_t k = 0; k < Lanes; ++k)
+				STATE[r][k] = state[r * Lanes + k];
+		return is;
+	}
+
+protected:
+	~BasicWELLEnsembleEngine()
+	{
+	}
+
+private:
+	static const unsigned int R = Params::R; ///< number of state words
+	static const unsigned int P = Params::P; ///< number of unused bits
+	static const unsigned int M1 = Params::M1;
+	static const unsigned int M2 = Params::M2;
+	static const unsigned int M3 = Params::M3;
+	static const uint32_t MASKU = P ? 0xffffffffU >> (32 - P) : 0U;
+	static const uint32_t MASKL = ~MASKU;
+
+	/// Reduce an index in [0, 2R) modulo R
+	static unsigned int mod(unsigned int i)
+	{
+		if ((R & (R - 1)) == 0)
+			return i & (R - 1);
+		return i < R ? i : i - R;
+	}
+
+	unsigned long int seed_; ///< the initial seed
+
+	unsigned int state_i;
+	alignas(64) uint32_t STATE[R][Lanes]; ///< row i holds word i of all lanes
+};
+
+/// @p Lanes WELL1024a generators in lock-step.
+template<std::size_t Lanes>
+using WELLEnsembleEngine = BasicWELLEnsembleEngine<WELL1024aParams, Lanes>;
+
+} /* namespace myrng */
+#endif /* ENSEMBLEENGINE_H_ */
@@ -0,0 +1,207 @@
+/**
+ * Random variates generation for ensembles of replicas
+ *
+ * @file EnsembleVariates.h
+ */
+
+#ifndef ENSEMBLEVARIATES_H_
+#define ENSEMBLEVARIATES_H_
+
+#include <cmath>
+#include <cassert>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include "serialize.h"
+
+namespace myrng
+{
+
+/**
+ * Random variates generation for all lanes of a multi-lane engine at once.
+ *
+ * The counterpart of RandomVariates for engines such as
+ * BasicWELLEnsembleEngine, which advance @c lanes() independent generators
+ * in lock-step. Every method writes one variate per lane into @p out, which
+ * has to hold @c lanes() elements; element @c k is drawn from lane @c k
+ * only. The loops over the lanes are kept free of branches so that the
+ * compiler can vectorize them.
+ * Example:
+ * @code
+ * const std::size_t N = 32;
+ * myrng::EnsembleVariates<myrng::WELLEnsembleEngine<N> > rng;
+ * double noise[N];
+ * rng.Seed(42);
+ * for (int t = 0; t < steps; ++t)
+ * {
+ *     rng.Normal01(noise);
+ *     for (std::size_t k = 0; k < N; ++k)
+ *         x[k] += dt * f(x[k]) + sqrt(dt) * noise[k];
+ * }
+ * @endcode
+ */
+template<class Engine>
+class EnsembleVariates: public Engine
+{
+public:
+	/// Number of lanes
+	static constexpr std::size_t LANES = Engine::lanes();
+
+	/**
+	 * Constructor
+	 */
+	EnsembleVariates() :
+			normal_hasvariate(false)
+	{
+		for (std::size_t k = 0; k < LANES; ++k)
+			normal_variate[k] = 0.;
+	}
+
+	/**
+	 *  Seed the random number generator engine.
+	 *
+	 *  This is an alias for Engine::seed()
+	 *  @param s New seed
+	 */
+	void Seed(unsigned long int s)
+	{
+		Engine::seed(s);
+		normal_hasvariate = false;
+	}
+
+	/**
+	 * Write the complete state to @p os.
+	 *
+	 * Saves the state of the engine together with the cached variates.
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		Engine::save(os);
+		serialize::writeUInt(os, normal_hasvariate, 1);
+		for (std::size_t k = 0; k < LANES; ++k)
+			serialize::writeDouble(os, normal_variate[k]);
+		return os;
+	}
+
+	/**
+	 * Restore a state written by save().
+	 *
+	 * On error the failbit of @p is is set.
+	 */
+	std::istream& load(std::istream& is)
+	{
+		uint64_t has;
+		double v[LANES];
+		if (!Engine::load(is) || !serialize::readUInt(is, has, 1))
+			return serialize::fail(is);
+		for (std::size_t k = 0; k < LANES; ++k)
+			if (!serialize::readDouble(is, v[k]))
+				return serialize::fail(is);
+		normal_hasvariate = has != 0;
+		for (std::size_t k = 0; k < LANES; ++k)
+			normal_variate[k] = v[k];
+		return is;
+	}
+
+	/**
+	 * Uniform distribution, see RandomVariates::Uniform01().
+	 */
+	void Uniform01(double* out)
+	{
+		const typename Engine::result_type* y = Engine::next();
+		for (std::size_t k = 0; k < LANES; ++k)
+			out[k] = Engine::canonical(y[k]);
+	}
+
+	/**
+	 * Uniform distribution on [0,1) in single precision, see
+	 * RandomVariates::Uniform01f().
+	 */
+	void Uniform01f(float* out)
+	{
+		const typename Engine::result_type* y = Engine::next();
+		for (std::size_t k = 0; k < LANES; ++k)
+			out[k] = (y[k] >> 8) * (1.0f / 16777216.0f);
+	}
+
+	/**
+	 * Uniform distribution on the interval [from,to).
+	 */
+	void FromTo(double* out, double from, double to)
+	{
+		Uniform01(out);
+		for (std::size_t k = 0; k < LANES; ++k)
+			out[k] = from + (to - from) * out[k];
+	}
+
+	/**
+	 * Set each element of @p out to true with probability @p chance.
+	 */
+	void Chance(bool* out, double chance = 0.5)
+	{
+		const typename Engine::result_type* y = Engine::next();
+		for (std::size_t k = 0; k < LANES; ++k)
+			out[k] = Engine::canonical(y[k]) <= chance;
+	}
+
+	/**
+	 * Normal(0,1) distribution.
+	 *
+	 * Uses the Box-Muller method rather than the polar method: it needs
+	 * exactly two uniforms per pair of variates in every lane, so the lanes
+	 * stay in lock-step without a rejection loop. The second variate of each
+	 * pair is cached.
+	 */
+	void Normal01(double* out)
+	{
+		if (normal_hasvariate)
+		{
+			normal_hasvariate = false;
+			for (std::size_t k = 0; k < LANES; ++k)
+				out[k] = normal_variate[k];
+			return;
+		}
+		double r[LANES];
+		Uniform01(r);
+		for (std::size_t k = 0; k < LANES; ++k)
+			r[k] = std::sqrt(-2.0 * std::log(1.0 - r[k])); // 1-U is in (0,1]
+		Uniform01(out);
+		for (std::size_t k = 0; k < LANES; ++k)
+		{
+			const double phi = 6.283185307179586477 * out[k];
+			normal_variate[k] = r[k] * std::sin(phi);
+			out[k] = r[k] * std::cos(phi);
+		}
+		normal_hasvariate = true;
+	}
+
+	/**
+	 * Gaussian distribution, see RandomVariates::GaussianPolar().
+	 */
+	void Gaussian(double* out, double mean, double variance)
+	{
+		Normal01(out);
+		const double sigma = std::sqrt(variance);
+		for (std::size_t k = 0; k < LANES; ++k)
+			out[k] = mean + sigma * out[k];
+	}
+
+	/**
+	 * Exponential distribution, see RandomVariates::Exponential().
+	 */
+	void Exponential(double* out, double mean)
+	{
+		assert(mean > 0);
+		Uniform01(out);
+		for (std::size_t k = 0; k < LANES; ++k)
+			out[k] = -mean * std::log(1.0 - out[k]); // 1-U is in (0,1]
+	}
+
+private:
+	// Box-Muller variables
+	bool normal_hasvariate; // The second variates are still stored
+	double normal_variate[LANES]; // The second variates
+};
+
+} /* namespace myrng */
+#endif /* ENSEMBLEVARIATES_H_ */
@@ -0,0 +1,257 @@
+/**
+ * Latin hypercube sampling
+ *
+ * @file LatinHypercubeEngine.h
+ */
+
+#ifndef LATINHYPERCUBEENGINE_H_
+#define LATINHYPERCUBEENGINE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include "QuasiVariates.h"
+#include "WELLEngine.h"
+#include "serialize.h"
+
+namespace myrng
+{
+
+/**
+ * Latin hypercube samples of @c points() points in @c dimension()
+ * dimensions, drawn with @p Engine.
+ *
+ * Each batch of n = points() consecutive points is a Latin hypercube: in
+ * every coordinate, exactly one point falls into each of the n intervals
+ * [k/n, (k+1)/n), at a uniformly distributed position. The strata are
+ * assigned to the points by an independent random permutation per
+ * coordinate, so each point on its own is uniform on the unit cube, while
+ * the batch covers every coordinate evenly. The estimate of an integral from
+ * one batch has a smaller variance than from n independent points whenever
+ * the integrand is dominated by additive effects of the coordinates
+ * (M. D. McKay, R. J. Beckman and W. J. Conover, Technometrics 21, 1979).
+ *
+ * The engine has the interface of SobolEngine, so QuasiVariates turns the
+ * points into variates:
+ * @code
+ * myrng::LatinHypercube lhs(4); // 4 input parameters of a simulation
+ * lhs.setPoints(100);           // 100 runs
+ * lhs.Seed(42);
+ * double p[4];
+ * for (int run = 0; run < 100; ++run)
+ * {
+ *     lhs.Normal01(p);
+ *     simulate(p);
+ * }
+ * @endcode
+ * @tparam Engine random number generator engine producing all 32 bits
+ */
+template<class Engine>
+class LatinHypercubeEngine: public Engine
+{
+public:
+	/// Type of the raw random numbers
+	typedef uint32_t result_type;
+
+	/**
+	 * Constructor
+	 * @param d dimension
+	 * @param n points per batch
+	 */
+	explicit LatinHypercubeEngine(std::size_t d = 1, std::size_t n = 1) :
+			d_(d), n_(n), i_(n), perm(d * n), point(d)
+	{
+		assert(d >= 1 && n >= 1);
+	}
+	/**
+	 * Set random number generator seed and start a new batch
+	 */
+	void seed(unsigned long int s)
+	{
+		Engine::seed(s);
+		i_ = n_;
+	}
+	/**
+	 * Set the number of points per batch, at most 2^32, and start a new batch
+	 */
+	void setPoints(std::size_t n)
+	{
+		assert(n >= 1 && n <= 0xffffffffULL + 1);
+		n_ = i_ = n;
+		perm.resize(d_ * n);
+	}
+	/**
+	 * Get the number of points per batch
+	 */
+	std::size_t points() const
+	{
+		return n_;
+	}
+	/**
+	 * Get the number of coordinates of a point
+	 */
+	std::size_t dimension() const
+	{
+		return d_;
+	}
+	/**
+	 * Smallest raw random number
+	 */
+	static constexpr result_type min()
+	{
+		return 0;
+	}
+	/**
+	 * Largest raw random number
+	 */
+	static constexpr result_type max()
+	{
+		return 0xffffffffU;
+	}
+	/**
+	 * Produce the next point of the batch, drawing a new batch if the
+	 * current one is exhausted.
+	 * @return pointer to @c dimension() raw numbers, valid until the next
+	 * call
+	 */
+	const result_type* next()
+	{
+		if (i_ == n_)
+			shuffle();
+		for (std::size_t j = 0; j < d_; ++j)
+		{
+			// a uniform position within stratum perm, scaled to 32 bits
+			const uint64_t k = perm[j * n_ + i_];
+			point[j] = static_cast<result_type>(((k << 32) + word()) / n_);
+		}
+		++i_;
+		return &point[0];
+	}
+	/**
+	 * Convert a raw random number to a double on the interval (0,1).
+	 */
+	static double canonical(result_type y)
+	{
+		return (y + 0.5) * (1.0 / 4294967296.0);
+	}
+	/**
+	 * Write the complete generator state to @p os.
+	 *
+	 * Saves the state of @p Engine together with the current batch.
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		Engine::save(os);
+		serialize::write32(os, d_);
+		serialize::write64(os, n_);
+		serialize::write64(os, i_);
+		for (std::size_t k = 0; k < perm.size(); ++k)
+			serialize::write32(os, perm[k]);
+		return os;
+	}
+	/**
+	 * Restore a generator state written by save().
+	 *
+	 * The dimension has to be the same. On error the failbit of @p is is
+	 * set and the state is left unchanged.
+	 */
+	std::istream& load(std::istream& is)
+	{
+		std::stringstream backup;
+		Engine::save(backup);
+		if (!Engine::load(is))
+			return serialize::fail(is);
+		std::size_t n, i;
+		std::vector<uint32_t> p;
+		if (!loadBatch(is, n, i, p))
+		{
+			Engine::load(backup);
+			return serialize::fail(is);
+		}
+		n_ = n;
+		i_ = i;
+		perm.swap(p);
+		return is;
+	}
+
+protected:
+	~LatinHypercubeEngine()
+	{
+	}
+
+private:
+	/**
+	 * Read the batch written by save() into @p n, @p i and @p p.
+	 *
+	 * @p p grows while reading, so that a corrupt number of points fails at
+	 * the end of the data instead of allocating its size up front.
+	 * @return false if the data is incomplete or inconsistent
+	 */
+	bool loadBatch(std::istream& is, std::size_t& n, std::size_t& i,
+			std::vector<uint32_t>& p) const
+	{
+		std::size_t d;
+		if (!serialize::read32(is, d) || d != d_ || !serialize::read64(is, n)
+				|| n < 1 || n > 0xffffffffULL + 1 || !serialize::read64(is, i)
+				|| i > n)
+			return false;
+		uint32_t k;
+		for (std::size_t m = 0; m < d * n; ++m)
+		{
+			// a stratum beyond n would give a coordinate beyond 1
+			if (!serialize::read32(is, k) || k >= n)
+				return false;
+			p.push_back(k);
+		}
+		return true;
+	}
+
+	/// 32 random bits from the engine
+	uint32_t word()
+	{
+		return static_cast<uint32_t>(Engine::operator()());
+	}
+	/// Draw a random permutation of the strata for every coordinate
+	void shuffle()
+	{
+		for (std::size_t j = 0; j < d_; ++j)
+		{
+			uint32_t* p = &perm[j * n_];
+			for (std::size_t k = 0; k < n_; ++k)
+				p[k] = static_cast<uint32_t>(k);
+			// Fisher-Yates with Lemire's unbiased multiply-shift
+			for (std::size_t k = n_ - 1; k > 0; --k)
+			{
+				const uint64_t span = k + 1;
+				uint64_t m = word() * span;
+				if ((m & 0xffffffffU) < span)
+				{
+					const uint64_t t = (uint64_t(1) << 32) % span;
+					while ((m & 0xffffffffU) < t)
+						m = word() * span;
+				}
+				std::swap(p[k], p[m >> 32]);
+			}
+		}
+		i_ = 0;
+	}
+
+	std::size_t d_; ///< dimension
+	std::size_t n_; ///< points per batch
+	std::size_t i_; ///< index of the next point in the batch
+	std::vector<uint32_t> perm; ///< stratum of point i in coordinate j at j n + i
+	std::vector<result_type> point; ///< the point returned by next()
+};
+
+/**
+ * Latin hypercube samples with random variates, see LatinHypercubeEngine.
+ */
+typedef QuasiVariates<LatinHypercubeEngine<WELLEngine> > LatinHypercube;
+
+} /* namespace myrng */
+#endif /* LATINHYPERCUBEENGINE_H_ */
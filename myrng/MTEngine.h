@@ -1,14 +1,21 @@
 #ifndef MTENGINE_H_
 #define MTENGINE_H_
 
-#include <cassert>
+#include <cstddef>
 #include <ctime>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+#include "jump.h"
+#include "serialize.h"
+#include "stats.h"
 
 namespace myrng
 {
 
 /**
- * The MT19937 random number generator.
+ * The Mersenne Twister family of random number generators.
  *
  * The Mersenne Twister has a ridiculous high period of 2^19937. If it is
  * seeded with a decent value the probability that the generator hits a bad
@@ -19,6 +26,13 @@ namespace myrng
  * But the seed function is written to avoid a bad initialization so this
  * generator can also be used without hesitation.
  *
+ * The recurrence is fixed at compile time by @p Params, which provides the
+ * word type and size @c W, the degree @c N, the middle word @c M, the
+ * separation point @c R, the twist matrix @c A, the tempering parameters
+ * @c U, @c D, @c S, @c B, @c T, @c C, @c L and the initialization multiplier
+ * @c F, as well as the name of the generator. See MT19937Params,
+ * MT11213Params and MT19937_64Params.
+ *
  * @see http://www.math.sci.hiroshima-u.ac.jp/~m-mat/MT/emt
  *
  * @author Gerd Zschaler <gzschaler@googlemail.com>
@@ -38,15 +52,20 @@ namespace myrng
  *      products derived from this software without specific prior written
  *      permission.
  */
-class MTEngine
+template<class Params>
+class BasicMTEngine
 {
 public:
-	MTEngine()
+	/// Unsigned integer type of the state words
+	typedef typename Params::word_type word_type;
+	/// Type of the raw random numbers
+	typedef word_type result_type;
+
+	BasicMTEngine()
 	{
-		// Long has to be at least 32 bits!
-		assert(sizeof(long) >= 4);
-		mti = 624 + 1;
-		//   unsigned long mt[624];
+		mti = N + 1;
+		incremental = lazy = false;
+		refills_ = 0;
 		seed((unsigned long) std::time(0));
 	}
 	/**
@@ -54,17 +73,17 @@ public:
 	 */
 	void seed(unsigned long int s)
 	{
-		mt[0] = s & 0xffffffffUL;
-		for (mti = 1; mti < 624; mti++)
+		seed_ = s;
+		mt[0] = s & WORDMASK;
+		for (mti = 1; mti < N; mti++)
 		{
-			mt[mti] =
-					(1812433253UL * (mt[mti - 1] ^ (mt[mti - 1] >> 30)) + mti);
+			mt[mti] = (Params::F * (mt[mti - 1] ^ (mt[mti - 1] >> (W - 2)))
+					+ mti);
 			// See Knuth TAOCP Vol2. 3rd Ed. P.106 for multiplier.
 			// In the previous versions, MSBs of the seed affect
 			// only MSBs of the array mt[].
 			// 2002/01/09 modified by Makoto Matsumoto
-			mt[mti] &= 0xffffffffUL;
-			// for >32 bit machines
+			mt[mti] &= WORDMASK;
 		}
 	}
 	/**
@@ -77,68 +96,402 @@ public:
 	/**
 	 * Get the name of the random number generator engine
 	 */
-	const char* getName()
+	static const char* getName()
 	{
-		return "MT19937";
+		return Params::name();
 	}
-
-protected:
-	~MTEngine()
+	/**
+	 * Smallest raw random number
+	 */
+	static constexpr result_type min()
 	{
+		return 0;
 	}
 	/**
-	 * Produce a random number.
+	 * Largest raw random number
 	 */
-	double operator()()
+	static constexpr result_type max()
+	{
+		return WORDMASK;
+	}
+	/**
+	 * Produce a raw random number.
+	 *
+	 * All @c W bits are uniformly distributed, so the engine can be used
+	 * directly with the distributions and algorithms of \<random\> and
+	 * \<algorithm\>, e.g. std::shuffle.
+	 */
+	result_type operator()()
 	{
 		/*
-		 * This generator is an implementation of MT19937.
+		 * This generator is an implementation of MT19937 and its relatives.
 		 * For more information visit
 		 * http://www.math.sci.hiroshima-u.ac.jp/~m-mat/MT/emt.html
 		 */
-		unsigned long y;
-		static unsigned long mag01[2] =
-		{ 0x0UL, 0x9908b0dfUL };
-		// mag01[x] = x * MATRIX_A  for x=0,1
+		word_type y;
 
-		if (mti >= 624) // generate N words at one time
+		if (mti >= N) // start a new block of N words
 		{
-			int kk;
+			MYRNG_COUNT(refills_);
+			lazy = incremental;
+			if (!lazy)
+				generate();
+			mti = 0;
+		}
+		if (lazy)
+			twist(mti);
+
+		y = mt[mti++];
 
-			for (kk = 0; kk < 624 - 397; kk++)
+		return temper(y);
+	}
+	/**
+	 * Write @p n raw numbers to @p out.
+	 *
+	 * Equivalent to @p n calls of operator()(), but the words of a block are
+	 * tempered in one loop without dependencies between its iterations,
+	 * which the compiler can vectorise.
+	 */
+	void fill(result_type* out, std::size_t n)
+	{
+		while (n > 0)
+		{
+			if (mti >= N)
 			{
-				y = (mt[kk] & 0x80000000UL) | (mt[kk + 1] & 0x7fffffffUL);
-				mt[kk] = mt[kk + 397] ^ (y >> 1) ^ mag01[y & 0x1UL];
+				MYRNG_COUNT(refills_);
+				lazy = incremental;
+				if (!lazy)
+					generate();
+				mti = 0;
 			}
-			for (; kk < 624 - 1; kk++)
+			std::size_t m = static_cast<std::size_t>(N - mti);
+			if (m > n)
+				m = n;
+			if (lazy)
+				for (std::size_t k = 0; k < m; ++k)
+				{
+					twist(mti);
+					out[k] = temper(mt[mti++]);
+				}
+			else
 			{
-				y = (mt[kk] & 0x80000000UL) | (mt[kk + 1] & 0x7fffffffUL);
-				mt[kk] = mt[kk + (397 - 624)] ^ (y >> 1) ^ mag01[y & 0x1UL];
+				const word_type* block = mt + mti;
+				for (std::size_t k = 0; k < m; ++k)
+					out[k] = temper(block[k]);
+				mti += static_cast<int>(m);
 			}
-			y = (mt[624 - 1] & 0x80000000UL) | (mt[0] & 0x7fffffffUL);
-			mt[624 - 1] = mt[397 - 1] ^ (y >> 1) ^ mag01[y & 0x1UL];
-
-			mti = 0;
+			out += m;
+			n -= m;
 		}
+	}
+	/**
+	 * Convert a raw random number to a double on the open interval (0,1).
+	 */
+	static double canonical(result_type y)
+	{
+		if (W == 32)
+			return (((double) y) + 0.5) * (1.0 / 4294967296.0);
+			/* divided by 2^32 */
+		return (((double) (y >> (W > 53 ? W - 53 : 0))) + 0.5)
+				* (1.0 / 9007199254740992.0);
+		/* upper 53 bits divided by 2^53 */
+	}
+	/**
+	 * Advance the state by @p z steps.
+	 *
+	 * Equivalent to @p z calls of operator()(), but for large @p z the
+	 * state is jumped ahead with the minimal polynomial of the recurrence,
+	 * see jump.h, which takes at most a fraction of a second for any @p z.
+	 * The first jump computes the polynomial once for all engines of this
+	 * type.
+	 */
+	void discard(unsigned long long z)
+	{
+		if (z < static_cast<unsigned long long>(N) * W)
+		{
+			while (z--)
+				(*this)();
+			return;
+		}
+		const jump::Polynomial c = jump::powerMod(z, minimalPolynomial());
+		std::vector<word_type> acc(N, 0);
+		int k = window();
+		for (int i = 0; i <= c.degree(); ++i)
+		{
+			if (c.coefficient(i))
+				for (int l = 0; l < N; ++l)
+					acc[l] ^= mt[k + l < N ? k + l : k + l - N];
+			twist(k);
+			k = (k + 1 < N) ? k + 1 : 0;
+		}
+		for (int l = 0; l < N; ++l)
+			mt[l] = acc[l];
+		mti = 0;
+		lazy = false;
+	}
+	/**
+	 * Switch between batch and incremental regeneration of the state.
+	 *
+	 * By default, all @c N words of the state are regenerated at once in
+	 * every @c N th call, which makes that call several hundred times slower
+	 * than the others. In incremental mode, every call regenerates the one
+	 * word it returns, so that all calls take the same time. Both modes
+	 * produce exactly the same sequence; incremental mode is slightly slower
+	 * on average.
+	 *
+	 * The new mode takes effect when the current block of @c N words is
+	 * used up, i.e. immediately after seed().
+	 */
+	void setIncremental(bool on)
+	{
+		incremental = on;
+	}
+	/**
+	 * Check whether incremental regeneration is selected
+	 */
+	bool isIncremental() const
+	{
+		return incremental;
+	}
+	/**
+	 * Get the number of regenerations of the state.
+	 *
+	 * Counts blocks of @c N words, whether regenerated at once or
+	 * incrementally. Always 0 unless compiled with -DMYRNG_STATS.
+	 */
+	unsigned long long getRefills() const
+	{
+		return refills_;
+	}
+	/**
+	 * Write the complete generator state to @p os.
+	 *
+	 * The state is written in a compact, platform independent binary format
+	 * and can be restored with load().
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		serialize::writeTag(os, getName());
+		serialize::write64(os, seed_);
+		serialize::write32(os, mti);
+		serialize::writeUInt(os, incremental | (lazy << 1), 1);
+		for (int i = 0; i < N; ++i)
+			serialize::writeUInt(os, mt[i], W / 8);
+		return os;
+	}
+	/**
+	 * Restore a generator state written by save().
+	 *
+	 * On error the failbit of @p is is set and the state is left unchanged.
+	 */
+	std::istream& load(std::istream& is)
+	{
+		unsigned long int s;
+		uint64_t state[N];
+		uint32_t i;
+		uint64_t mode;
+		if (!serialize::readTag(is, getName()) || !serialize::read64(is, s)
+				|| !serialize::read32(is, i) || i > static_cast<uint32_t>(N)
+				|| !serialize::readUInt(is, mode, 1))
+			return serialize::fail(is);
+		for (int k = 0; k < N; ++k)
+			if (!serialize::readUInt(is, state[k], W / 8))
+				return serialize::fail(is);
+		seed_ = s;
+		mti = static_cast<int>(i);
+		incremental = mode & 1;
+		lazy = (mode & 2) != 0;
+		for (int k = 0; k < N; ++k)
+			mt[k] = static_cast<word_type>(state[k]);
+		return is;
+	}
 
-		y = mt[mti++];
+protected:
+	~BasicMTEngine()
+	{
+	}
 
-		/* Tempering */
-		y ^= (y >> 11);
-		y ^= (y << 7) & 0x9d2c5680UL;
-		y ^= (y << 15) & 0xefc60000UL;
-		y ^= (y >> 18);
+private:
+	static const int W = Params::W; ///< word size in bits
+	static const int N = Params::N; ///< number of state words
+	static const int M = Params::M; ///< middle word
+	static const word_type WORDMASK = ~word_type(0) >> (sizeof(word_type) * 8
+			- W);
+	static const word_type LOWERMASK = (word_type(1) << Params::R) - 1;
+	static const word_type UPPERMASK = WORDMASK & ~LOWERMASK;
 
-		return (((double) y) + 0.5) * (1.0 / 4294967296.0);
-		/* divided by 2^32 */
+	/// Tempering of a state word
+	static word_type temper(word_type y)
+	{
+		y ^= (y >> Params::U) & Params::D;
+		y ^= (y << Params::S) & Params::B;
+		y ^= (y << Params::T) & Params::C;
+		y ^= (y >> Params::L);
+		return y;
+	}
+	/// Generate N words at one time
+	void generate()
+	{
+		word_type y;
+		int kk;
+
+		// (0 - (y & 1)) & A selects 0 or MATRIX_A without a table lookup,
+		// so that the loops can be vectorised
+		for (kk = 0; kk < N - M; kk++)
+		{
+			y = (mt[kk] & UPPERMASK) | (mt[kk + 1] & LOWERMASK);
+			mt[kk] = mt[kk + M] ^ (y >> 1)
+					^ ((word_type(0) - (y & 0x1)) & Params::A);
+		}
+		for (; kk < N - 1; kk++)
+		{
+			y = (mt[kk] & UPPERMASK) | (mt[kk + 1] & LOWERMASK);
+			mt[kk] = mt[kk + (M - N)] ^ (y >> 1)
+					^ ((word_type(0) - (y & 0x1)) & Params::A);
+		}
+		y = (mt[N - 1] & UPPERMASK) | (mt[0] & LOWERMASK);
+		mt[N - 1] = mt[M - 1] ^ (y >> 1)
+				^ ((word_type(0) - (y & 0x1)) & Params::A);
+	}
+	/**
+	 * Regenerate the single word mt[kk].
+	 *
+	 * Lagged-index form of generate(): words below kk already belong to the
+	 * new block, words from kk on to the old one.
+	 */
+	void twist(int kk)
+	{
+		word_type y;
+		const word_type mag01[2] =
+		{ 0, Params::A };
+		int k1 = (kk + 1 < N) ? kk + 1 : 0;
+		int km = (kk + M < N) ? kk + M : kk + (M - N);
+
+		y = (mt[kk] & UPPERMASK) | (mt[k1] & LOWERMASK);
+		mt[kk] = mt[km] ^ (y >> 1) ^ mag01[y & 0x1];
+	}
+
+	/**
+	 * Regenerate words until the next N words to be returned are in mt[].
+	 *
+	 * @return the index of the next word; the following ones come
+	 * cyclically after it
+	 */
+	int window()
+	{
+		if (lazy)
+			for (int kk = mti; kk < N; ++kk)
+				twist(kk);
+		lazy = false;
+		for (int kk = 0; kk < mti; ++kk)
+			twist(kk);
+		return mti < N ? mti : 0;
+	}
+	/// Minimal polynomial of the recurrence, computed on first use
+	static const jump::Polynomial& minimalPolynomial()
+	{
+		static const jump::Polynomial p = computeMinimalPolynomial();
+		return p;
+	}
+	/// Run Berlekamp-Massey on the lowest bit of 2 N W numbers
+	static jump::Polynomial computeMinimalPolynomial()
+	{
+		BasicMTEngine e;
+		e.seed(5489);
+		std::vector<bool> s(2 * N * W);
+		for (std::size_t i = 0; i < s.size(); ++i)
+			s[i] = e() & 1;
+		return jump::berlekampMassey(s);
 	}
 
-private:
 	unsigned long int seed_; ///< the initial seed
-	unsigned long int mt[624]; ///< state vector
-	int mti; // mti==625 means mt[] is not initialized
+	word_type mt[N]; ///< state vector
+	int mti; // mti==N+1 means mt[] is not initialized
+	bool incremental; ///< regenerate one word per call
+	bool lazy; ///< the current block is regenerated incrementally
+	/// number of blocks regenerated; kept without -DMYRNG_STATS as well, so
+	/// that the layout does not depend on the flag
+	unsigned long long refills_;
+
+};
 
+/**
+ * Parameters of MT19937 (period 2^19937-1).
+ */
+struct MT19937Params
+{
+	typedef uint32_t word_type;
+	enum
+	{
+		W = 32, N = 624, M = 397, R = 31, U = 11, S = 7, T = 15, L = 18
+	};
+	static const uint32_t A = 0x9908b0dfU;
+	static const uint32_t D = 0xffffffffU;
+	static const uint32_t B = 0x9d2c5680U;
+	static const uint32_t C = 0xefc60000U;
+	static const uint32_t F = 1812433253U;
+	static const char* name()
+	{
+		return "MT19937";
+	}
+};
+
+/**
+ * Parameters of MT11213B (period 2^11213-1).
+ *
+ * A smaller relative of MT19937 with a state of 351 words, as in
+ * Boost.Random.
+ */
+struct MT11213Params
+{
+	typedef uint32_t word_type;
+	enum
+	{
+		W = 32, N = 351, M = 175, R = 19, U = 11, S = 7, T = 15, L = 17
+	};
+	static const uint32_t A = 0xccab8ee7U;
+	static const uint32_t D = 0xffffffffU;
+	static const uint32_t B = 0x31b6ab00U;
+	static const uint32_t C = 0xffe50000U;
+	static const uint32_t F = 1812433253U;
+	static const char* name()
+	{
+		return "MT11213B";
+	}
+};
+
+/**
+ * Parameters of MT19937-64 (period 2^19937-1).
+ *
+ * The 64-bit Mersenne Twister by Nishimura and Matsumoto. Its numbers have
+ * the full 53 bits of resolution of a double.
+ */
+struct MT19937_64Params
+{
+	typedef uint64_t word_type;
+	enum
+	{
+		W = 64, N = 312, M = 156, R = 31, U = 29, S = 17, T = 37, L = 43
+	};
+	static const uint64_t A = 0xb5026f5aa96619e9ULL;
+	static const uint64_t D = 0x5555555555555555ULL;
+	static const uint64_t B = 0x71d67fffeda60000ULL;
+	static const uint64_t C = 0xfff7eee000000000ULL;
+	static const uint64_t F = 6364136223846793005ULL;
+	static const char* name()
+	{
+		return "MT19937-64";
+	}
 };
 
+/// The MT19937 random number generator.
+typedef BasicMTEngine<MT19937Params> MTEngine;
+
+/// The MT11213B random number generator.
+typedef BasicMTEngine<MT11213Params> MT11213Engine;
+
+/// The 64-bit MT19937-64 random number generator.
+typedef BasicMTEngine<MT19937_64Params> MT19937_64Engine;
+
 } /* namespace myrng */
 #endif /* MTENGINE_H_ */
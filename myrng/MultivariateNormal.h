@@ -0,0 +1,343 @@
+/**
+ * Multivariate normal distribution
+ *
+ * @file MultivariateNormal.h
+ */
+
+#ifndef MULTIVARIATENORMAL_H_
+#define MULTIVARIATENORMAL_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace myrng
+{
+
+/**
+ * Correlated normal vectors with a given mean and covariance matrix.
+ *
+ * setCovariance() factors the covariance matrix C once into C = A A^T and
+ * caches A; every vector is then x = mean + A z with z a vector of
+ * independent Normal01Polar() variates. A is the Cholesky factor if C is
+ * positive definite. Otherwise, e.g. for perfectly correlated components, A
+ * = Q sqrt(D) is obtained from the eigendecomposition C = Q D Q^T by the
+ * Jacobi method, which handles any positive semi-definite matrix.
+ *
+ * The batch form generates many vectors at once in structure-of-arrays
+ * layout, like RandomVariates::UnitVectors(): component k of vector i is
+ * stored at out[k n + i]. It fills the whole block with normal variates and
+ * multiplies it by A in tiles of vectors that fit into the cache, with
+ * contiguous inner loops that the compiler vectorises. The tile is kept
+ * between calls, so drawing does not allocate memory once it has grown.
+ * Example:
+ * @code
+ * myrng::MultivariateNormal noise;
+ * if (!noise.setCovariance(&C[0], d))
+ *     error("C is not a covariance matrix");
+ * std::vector<double> dW(d * steps);
+ * noise(rng, &dW[0], steps); // dW[k * steps + t]: component k at step t
+ * @endcode
+ */
+class MultivariateNormal
+{
+public:
+	/**
+	 * Constructor, the standard normal distribution in one dimension
+	 */
+	MultivariateNormal() :
+			d_(1), cholesky(true), A(1, 1.), mu(1, 0.)
+	{
+	}
+
+	/**
+	 * Set and factor the covariance matrix, and set the mean to zero.
+	 *
+	 * @param cov symmetric d x d matrix in row-major order
+	 * @param d dimension
+	 * @return false if @p cov is not positive semi-definite; the
+	 * distribution is then left unchanged
+	 */
+	bool setCovariance(const double* cov, std::size_t d)
+	{
+		assert(d >= 1);
+		std::vector<double> a(cov, cov + d * d);
+		bool chol = factorCholesky(a, d);
+		if (!chol)
+		{
+			a.assign(cov, cov + d * d);
+			if (!factorEigen(a, d))
+				return false;
+		}
+		d_ = d;
+		cholesky = chol;
+		A.swap(a);
+		mu.assign(d, 0.);
+		return true;
+	}
+	/**
+	 * Set the mean vector of @c dimension() elements
+	 */
+	void setMean(const double* mean)
+	{
+		mu.assign(mean, mean + d_);
+	}
+	/**
+	 * Get the dimension
+	 */
+	std::size_t dimension() const
+	{
+		return d_;
+	}
+	/**
+	 * Check whether the covariance matrix has been factored by Cholesky
+	 * decomposition, i.e. is positive definite, rather than by
+	 * eigendecomposition.
+	 */
+	bool isCholesky() const
+	{
+		return cholesky;
+	}
+	/**
+	 * Get the factor A with C = A A^T, row-major, lower triangular if
+	 * isCholesky()
+	 */
+	const std::vector<double>& factor() const
+	{
+		return A;
+	}
+
+	/**
+	 * Draw one vector into @p x, which has to hold @c dimension() elements.
+	 *
+	 * Multiplies directly with A, without the tiling of the batch form and
+	 * without allocating memory after the first call.
+	 * @param rng random variates, e.g. myrng::WELL1024a
+	 */
+	template<class RNG>
+	void operator()(RNG& rng, double* x)
+	{
+		if (z.size() < d_)
+			z.resize(d_);
+		for (std::size_t k = 0; k < d_; ++k)
+			z[k] = rng.Normal01Polar();
+		for (std::size_t k = 0; k < d_; ++k)
+		{
+			double s = mu[k];
+			const std::size_t end = cholesky ? k + 1 : d_;
+			for (std::size_t j = 0; j < end; ++j)
+				s += A[k * d_ + j] * z[j];
+			x[k] = s;
+		}
+	}
+	/**
+	 * Draw @p n vectors into @p out, component k of vector i at
+	 * out[k n + i].
+	 *
+	 * The vectors are the same as those of @p n calls of the single-vector
+	 * form, up to rounding.
+	 * @param rng random variates, e.g. myrng::WELL1024a
+	 */
+	template<class RNG>
+	void operator()(RNG& rng, double* out, std::size_t n)
+	{
+		// draw in the order of the single-vector form
+		for (std::size_t i = 0; i < n; ++i)
+			for (std::size_t k = 0; k < d_; ++k)
+				out[k * n + i] = rng.Normal01Polar();
+		multiply(out, n);
+	}
+
+private:
+	/// Size of a tile of the normal variates in doubles, 128 kB
+	static const std::size_t TILE = 16384;
+
+	/**
+	 * Replace the lower triangle of @p a by its Cholesky factor and clear
+	 * the upper triangle.
+	 * @return false if @p a is not positive definite
+	 */
+	static bool factorCholesky(std::vector<double>& a, std::size_t d)
+	{
+		double scale = 0.;
+		for (std::size_t k = 0; k < d; ++k)
+			scale = std::fmax(scale, std::fabs(a[k * d + k]));
+		for (std::size_t j = 0; j < d; ++j)
+		{
+			double s = a[j * d + j];
+			for (std::size_t k = 0; k < j; ++k)
+				s -= a[j * d + k] * a[j * d + k];
+			// reject pivots lost in rounding, they would amplify the noise
+			if (!(s > 1e-12 * scale))
+				return false;
+			const double l = std::sqrt(s);
+			a[j * d + j] = l;
+			for (std::size_t i = j + 1; i < d; ++i)
+			{
+				double t = a[i * d + j];
+				for (std::size_t k = 0; k < j; ++k)
+					t -= a[i * d + k] * a[j * d + k];
+				a[i * d + j] = t / l;
+				a[j * d + i] = 0.;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Replace @p a by Q sqrt(D) from its eigendecomposition Q D Q^T,
+	 * computed with the cyclic Jacobi method.
+	 * @return false if @p a has a clearly negative eigenvalue
+	 */
+	static bool factorEigen(std::vector<double>& a, std::size_t d)
+	{
+		std::vector<double> q(d * d, 0.);
+		for (std::size_t k = 0; k < d; ++k)
+			q[k * d + k] = 1.;
+		double norm = 0.;
+		for (std::size_t k = 0; k < d * d; ++k)
+			norm += a[k] * a[k];
+		for (int sweep = 0; sweep < 100; ++sweep)
+		{
+			double off = 0.;
+			for (std::size_t p = 0; p < d; ++p)
+				for (std::size_t r = p + 1; r < d; ++r)
+					off += a[p * d + r] * a[p * d + r];
+			if (off <= 1e-30 * norm)
+				break;
+			for (std::size_t p = 0; p < d; ++p)
+				for (std::size_t r = p + 1; r < d; ++r)
+					rotate(a, q, d, p, r);
+		}
+		double largest = 0.;
+		for (std::size_t k = 0; k < d; ++k)
+			largest = std::fmax(largest, std::fabs(a[k * d + k]));
+		std::vector<double> root(d);
+		for (std::size_t k = 0; k < d; ++k)
+		{
+			const double lambda = a[k * d + k];
+			if (lambda < -1e-10 * largest)
+				return false;
+			root[k] = lambda > 0 ? std::sqrt(lambda) : 0.;
+		}
+		for (std::size_t i = 0; i < d; ++i)
+			for (std::size_t k = 0; k < d; ++k)
+				a[i * d + k] = q[i * d + k] * root[k];
+		return true;
+	}
+
+	/// Jacobi rotation annihilating a[p][r] of the symmetric matrix @p a,
+	/// accumulated into the eigenvectors @p q
+	static void rotate(std::vector<double>& a, std::vector<double>& q,
+			std::size_t d, std::size_t p, std::size_t r)
+	{
+		const double apr = a[p * d + r];
+		if (apr == 0.)
+			return;
+		// numerically stable rotation, see Numerical Recipes, section 11.1
+		const double theta = (a[r * d + r] - a[p * d + p]) / (2. * apr);
+		const double t = (theta >= 0 ? 1. : -1.)
+				/ (std::fabs(theta) + std::sqrt(theta * theta + 1.));
+		const double c = 1. / std::sqrt(t * t + 1.), s = t * c;
+		for (std::size_t k = 0; k < d; ++k)
+		{
+			// columns p and r
+			const double akp = a[k * d + p], akr = a[k * d + r];
+			a[k * d + p] = c * akp - s * akr;
+			a[k * d + r] = s * akp + c * akr;
+		}
+		for (std::size_t k = 0; k < d; ++k)
+		{
+			// rows p and r
+			const double apk = a[p * d + k], ark = a[r * d + k];
+			a[p * d + k] = c * apk - s * ark;
+			a[r * d + k] = s * apk + c * ark;
+		}
+		a[p * d + r] = a[r * d + p] = 0.;
+		for (std::size_t k = 0; k < d; ++k)
+		{
+			const double qkp = q[k * d + p], qkr = q[k * d + r];
+			q[k * d + p] = c * qkp - s * qkr;
+			q[k * d + r] = s * qkp + c * qkr;
+		}
+	}
+
+	/**
+	 * Replace the normal variates in @p out by mean + A z, one tile of
+	 * vectors at a time.
+	 *
+	 * Four components are computed together, so that each variate loaded
+	 * from the tile serves four multiply-adds. The upper triangle of a
+	 * Cholesky factor is skipped.
+	 */
+	void multiply(double* out, std::size_t n)
+	{
+		std::size_t width = TILE / d_;
+		width = width < 8 ? 8 : width - width % 8;
+		if (width > n)
+			width = n;
+		if (z.size() < d_ * width)
+			z.resize(d_ * width);
+		for (std::size_t i0 = 0; i0 < n; i0 += width)
+		{
+			const std::size_t w = n - i0 < width ? n - i0 : width;
+			for (std::size_t k = 0; k < d_; ++k)
+				for (std::size_t i = 0; i < w; ++i)
+					z[k * width + i] = out[k * n + i0 + i];
+			std::size_t k = 0;
+			for (; k + 4 <= d_; k += 4)
+			{
+				double* x0 = out + k * n + i0;
+				double* x1 = x0 + n;
+				double* x2 = x1 + n;
+				double* x3 = x2 + n;
+				for (std::size_t i = 0; i < w; ++i)
+				{
+					x0[i] = mu[k];
+					x1[i] = mu[k + 1];
+					x2[i] = mu[k + 2];
+					x3[i] = mu[k + 3];
+				}
+				const std::size_t end = cholesky ? k + 4 : d_;
+				for (std::size_t j = 0; j < end; ++j)
+				{
+					const double a0 = A[k * d_ + j], a1 = A[(k + 1) * d_ + j];
+					const double a2 = A[(k + 2) * d_ + j], a3 = A[(k + 3) * d_ + j];
+					const double* zj = &z[j * width];
+					for (std::size_t i = 0; i < w; ++i)
+					{
+						const double v = zj[i];
+						x0[i] += a0 * v;
+						x1[i] += a1 * v;
+						x2[i] += a2 * v;
+						x3[i] += a3 * v;
+					}
+				}
+			}
+			for (; k < d_; ++k)
+			{
+				double* x = out + k * n + i0;
+				for (std::size_t i = 0; i < w; ++i)
+					x[i] = mu[k];
+				const std::size_t end = cholesky ? k + 1 : d_;
+				for (std::size_t j = 0; j < end; ++j)
+				{
+					const double a = A[k * d_ + j];
+					const double* zj = &z[j * width];
+					for (std::size_t i = 0; i < w; ++i)
+						x[i] += a * zj[i];
+				}
+			}
+		}
+	}
+
+	std::size_t d_; ///< dimension
+	bool cholesky; ///< A is the lower triangular Cholesky factor
+	std::vector<double> A; ///< factor of the covariance matrix, row-major
+	std::vector<double> mu; ///< mean
+	std::vector<double> z; ///< normal variates of one vector or tile
+};
+
+} /* namespace myrng */
+#endif /* MULTIVARIATENORMAL_H_ */
@@ -0,0 +1,169 @@
+/**
+ * Random variates from quasi-random sequences
+ *
+ * @file QuasiVariates.h
+ */
+
+#ifndef QUASIVARIATES_H_
+#define QUASIVARIATES_H_
+
+#include <cmath>
+#include <cassert>
+#include <cstddef>
+#include "SobolEngine.h"
+
+namespace myrng
+{
+
+/**
+ * Random variates generation for the points of a quasi-random sequence.
+ *
+ * The counterpart of RandomVariates for engines such as SobolEngine or
+ * LatinHypercubeEngine, whose next() returns a point in @c dimension()
+ * dimensions. Every method consumes exactly one point and writes one variate
+ * per coordinate into @p out, which has to hold @c dimension() elements. All
+ * transformations map one uniform coordinate to one variate by its inverse
+ * distribution function, so that the points keep their low discrepancy or
+ * stratification; rejection methods or the polar method would destroy it.
+ * Example:
+ * @code
+ * myrng::Sobol qrng(2);
+ * double z[2];
+ * qrng.Seed(42);
+ * qrng.Normal01(z); // a well spread point of the standard normal in 2D
+ * @endcode
+ */
+template<class Engine>
+class QuasiVariates: public Engine
+{
+public:
+	/**
+	 * Constructor
+	 * @param d dimension of the points
+	 */
+	explicit QuasiVariates(std::size_t d = 1) :
+			Engine(d)
+	{
+	}
+
+	/**
+	 *  Seed the random number generator engine.
+	 *
+	 *  This is an alias for Engine::seed()
+	 *  @param s New seed
+	 */
+	void Seed(unsigned long int s)
+	{
+		Engine::seed(s);
+	}
+
+	/**
+	 * Uniform distribution on (0,1).
+	 */
+	void Uniform01(double* out)
+	{
+		const typename Engine::result_type* y = Engine::next();
+		for (std::size_t j = 0; j < Engine::dimension(); ++j)
+			out[j] = Engine::canonical(y[j]);
+	}
+
+	/**
+	 * Uniform distribution on the interval (from,to).
+	 */
+	void FromTo(double* out, double from, double to)
+	{
+		Uniform01(out);
+		for (std::size_t j = 0; j < Engine::dimension(); ++j)
+			out[j] = from + (to - from) * out[j];
+	}
+
+	/**
+	 * Normal(0,1) distribution by inversion.
+	 */
+	void Normal01(double* out)
+	{
+		Uniform01(out);
+		for (std::size_t j = 0; j < Engine::dimension(); ++j)
+			out[j] = inverseNormal(out[j]);
+	}
+
+	/**
+	 * Gaussian distribution, see RandomVariates::GaussianPolar().
+	 */
+	void Gaussian(double* out, double mean, double variance)
+	{
+		Normal01(out);
+		const double sigma = std::sqrt(variance);
+		for (std::size_t j = 0; j < Engine::dimension(); ++j)
+			out[j] = mean + sigma * out[j];
+	}
+
+	/**
+	 * Exponential distribution, see RandomVariates::Exponential().
+	 */
+	void Exponential(double* out, double mean)
+	{
+		assert(mean > 0);
+		Uniform01(out);
+		for (std::size_t j = 0; j < Engine::dimension(); ++j)
+			out[j] = -mean * std::log(out[j]);
+	}
+
+	/**
+	 * Inverse of the standard normal distribution function.
+	 *
+	 * The rational approximation of P. J. Acklam with a relative error of
+	 * 1.2e-9, refined by one step of Halley's method to full precision.
+	 * @param p probability in (0,1)
+	 */
+	static double inverseNormal(double p)
+	{
+		static const double a[] =
+		{ -3.969683028665376e+01, 2.209460984245205e+02,
+				-2.759285104469687e+02, 1.383577518672690e+02,
+				-3.066479806614716e+01, 2.506628277459239e+00 };
+		static const double b[] =
+		{ -5.447609879822406e+01, 1.615858368580409e+02,
+				-1.556989798598866e+02, 6.680131188771972e+01,
+				-1.328068155288572e+01 };
+		static const double c[] =
+		{ -7.784894002430293e-03, -3.223964580411365e-01,
+				-2.400758277161838e+00, -2.549732539343734e+00,
+				4.374664141464968e+00, 2.938163982698783e+00 };
+		static const double d[] =
+		{ 7.784695709041462e-03, 3.224671290700398e-01,
+				2.445134137142996e+00, 3.754408661907416e+00 };
+		assert(p > 0 && p < 1);
+		double x;
+		if (p < 0.02425 || p > 1 - 0.02425)
+		{
+			// tails
+			const double q = std::sqrt(-2 * std::log(p < 0.5 ? p : 1 - p));
+			x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q
+					+ c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+			if (p > 0.5)
+				x = -x;
+		}
+		else
+		{
+			const double q = p - 0.5, r = q * q;
+			x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r
+					+ a[5]) * q
+					/ (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r
+							+ 1);
+		}
+		// Halley step on Phi(x) - p, with Phi computed from erfc
+		const double e = 0.5 * std::erfc(-x / std::sqrt(2.)) - p;
+		const double u = e * std::sqrt(2 * 3.14159265358979323846)
+				* std::exp(x * x / 2);
+		return x - u / (1 + x * u / 2);
+	}
+};
+
+/**
+ * Scrambled Sobol points with random variates, see SobolEngine.
+ */
+typedef QuasiVariates<SobolEngine> Sobol;
+
+} /* namespace myrng */
+#endif /* QUASIVARIATES_H_ */
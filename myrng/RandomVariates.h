@@ -9,6 +9,14 @@
 
 #include <cmath>
 #include <cassert>
+#include <cstddef>
+#include <limits>
+#include <istream>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include "serialize.h"
+#include "stats.h"
 
 namespace myrng
 {
@@ -19,16 +27,83 @@ namespace myrng
  * Generates random variates according to different distributions
  * using the supplied random number generator @p Engine.
  *
+ * The raw interface of the engine, i.e. @c result_type, @c min(), @c max()
+ * and the call operator returning raw integers, is inherited, so a
+ * RandomVariates object is a UniformRandomBitGenerator and can be passed to
+ * the distributions and algorithms of the standard library:
+ * \code
+ *   myrng::MT19937 rng;
+ *   std::shuffle(v.begin(), v.end(), rng);
+ *   std::poisson_distribution<int> poisson(3.5);
+ *   int k = poisson(rng);
+ * \endcode
+ * Besides this interface, @p Engine has to provide the static function
+ * @c canonical(), which converts a raw number to a double on (0,1) or [0,1).
+ *
+ * If compiled with -DMYRNG_STATS, the generator counts the raw words drawn,
+ * the regenerations of the engine state, the iterations of the rejection
+ * loops and the calls of each distribution, see stats(). Without this flag
+ * the counting is compiled out; the counters are still members, so that
+ * code compiled with and without the flag can be linked together.
+ *
  * @author Gerd Zschaler <gzschaler@googlemail.com>
  */
 template<class Engine>
 class RandomVariates: public Engine
 {
 public:
+	typedef typename Engine::result_type result_type;
+
 	/**
 	 * Constructor
 	 */
-	RandomVariates() {}
+	RandomVariates() :
+			polar_hasvariate(false), polar_variate(0.), polarf_hasvariate(
+					false), polarf_variate(0.f), bit_buffer(0), bit_count(0),
+			zipf_s(0.), zipf_n(0.), zipf_hx1(0.), zipf_hn(0.), zipf_c(0.),
+			zipf_noreject(0.), zeta_s(0.), zeta_g1(0.), zeta_c(0.),
+			zeta_noreject(0.), binomial_n(-1.),
+			binomial_p(0.), binomial_a(0.), binomial_b(0.), binomial_c(0.),
+			binomial_vr(0.), binomial_alpha(0.), binomial_lpq(0.),
+			binomial_m(0.), binomial_h(0.), refills0(0)
+	{
+	}
+
+	/**
+	 * Produce a raw random number of the engine.
+	 */
+	result_type operator()()
+	{
+		MYRNG_COUNT(stats_.words);
+		return Engine::operator()();
+	}
+
+	/**
+	 * Get the instrumentation counters.
+	 *
+	 * The counters are only maintained if compiled with -DMYRNG_STATS,
+	 * otherwise all of them are zero.
+	 * \return the counts since construction or the last resetStats()
+	 */
+	Stats stats() const
+	{
+#ifdef MYRNG_STATS
+		Stats s = stats_;
+		s.refills = Engine::getRefills() - refills0;
+		return s;
+#else
+		return Stats();
+#endif
+	}
+
+	/**
+	 * Set the instrumentation counters to zero.
+	 */
+	void resetStats()
+	{
+		stats_.reset();
+		refills0 = Engine::getRefills();
+	}
 
 	/**
 	 *  Seed the random number generator engine.
@@ -39,6 +114,67 @@ public:
 	void Seed(unsigned long int s)
 	{
 		Engine::seed(s);
+		polar_hasvariate = false;
+		polarf_hasvariate = false;
+		bit_count = 0;
+	}
+
+	/**
+	 * Write the complete state to @p os.
+	 *
+	 * Saves the state of the engine together with the cached variates, so
+	 * that a generator restored with load() continues with exactly the same
+	 * sequence of random variates.
+	 * Example:
+	 * \code
+	 *   std::ofstream out("checkpoint.bin", std::ios::binary);
+	 *   rng.save(out);
+	 *   ...
+	 *   std::ifstream in("checkpoint.bin", std::ios::binary);
+	 *   if (!rng.load(in))
+	 *       std::cerr << "Cannot restore checkpoint\n";
+	 * \endcode
+	 * \param os binary output stream
+	 * \return @p os
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		Engine::save(os);
+		serialize::writeUInt(os, polar_hasvariate, 1);
+		serialize::writeDouble(os, polar_variate);
+		serialize::writeUInt(os, polarf_hasvariate, 1);
+		serialize::writeDouble(os, polarf_variate);
+		serialize::writeUInt(os, bit_count, 1);
+		serialize::writeUInt(os, bit_buffer, DIGITS / 8);
+		return os;
+	}
+
+	/**
+	 * Restore a state written by save().
+	 *
+	 * On error the failbit of @p is is set; the cached variates are then
+	 * left unchanged.
+	 * \param is binary input stream
+	 * \return @p is
+	 */
+	std::istream& load(std::istream& is)
+	{
+		uint64_t has, hasf, count, buffer;
+		double v, vf;
+		if (!Engine::load(is) || !serialize::readUInt(is, has, 1)
+				|| !serialize::readDouble(is, v)
+				|| !serialize::readUInt(is, hasf, 1)
+				|| !serialize::readDouble(is, vf)
+				|| !serialize::readUInt(is, count, 1) || count > DIGITS
+				|| !serialize::readUInt(is, buffer, DIGITS / 8))
+			return serialize::fail(is);
+		polar_hasvariate = has != 0;
+		polar_variate = v;
+		polarf_hasvariate = hasf != 0;
+		polarf_variate = static_cast<float>(vf);
+		bit_count = static_cast<unsigned int>(count);
+		bit_buffer = static_cast<result_type>(buffer);
+		return is;
 	}
 
 	/**
@@ -55,7 +191,78 @@ public:
 	 */
 	double Uniform01()
 	{
-		return (*this)();
+		MYRNG_COUNT(stats_.calls[Stats::UNIFORM01]);
+		return Engine::canonical((*this)());
+	}
+
+	/**
+	 * Uniform distribution on (0,1) with the full resolution of a double.
+	 *
+	 * Uniform01() has the resolution of one raw number, i.e. only 2^32
+	 * distinct values for the 32-bit engines. This method builds the
+	 * double from 53 random bits, which take one raw number of a 64-bit
+	 * engine such as MT19937_64, and two of a 32-bit engine.
+	 * \return \f$ (k + 1/2) / 2^{53} \f$ with \f$ k \f$ uniform on
+	 * \f$ 0,\dots,2^{53}-1 \f$.
+	 */
+	double Uniform01_53()
+	{
+		MYRNG_COUNT(stats_.calls[Stats::UNIFORM01_53]);
+		return ((bits64() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+	}
+
+	/**
+	 * Fill @p out with @p n numbers from Uniform01().
+	 */
+	void Uniform01(double* out, std::size_t n)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+			out[i] = Uniform01();
+	}
+
+	/**
+	 * Fill @p out with @p n numbers from Uniform01() using @p nthreads
+	 * threads.
+	 *
+	 * The array is split into one chunk per thread. Each thread jumps its
+	 * own copy of the engine to the start of its chunk with discard() and
+	 * fills the chunk, so @p out is identical to the result of the serial
+	 * Uniform01(out, n) with the same seed, whatever the number of threads.
+	 * Afterwards the generator continues behind the last number, as after
+	 * the serial fill. Requires an engine with jump-ahead, i.e. a WELL or
+	 * Mersenne Twister engine, and compiling with -pthread.
+	 * Example:
+	 * @code
+	 * std::vector<double> u(1000000000);
+	 * rng.Uniform01(&u[0], u.size(), 0); // same numbers on any machine
+	 * @endcode
+	 * @param nthreads number of threads, 0 for one per core
+	 */
+	void Uniform01(double* out, std::size_t n, unsigned int nthreads)
+	{
+		if (nthreads == 0)
+			nthreads = std::thread::hardware_concurrency();
+		if (nthreads <= 1 || n < 2)
+		{
+			Uniform01(out, n);
+			return;
+		}
+		const std::size_t chunk = (n + nthreads - 1) / nthreads;
+		nthreads = static_cast<unsigned int>((n + chunk - 1) / chunk);
+		std::vector<RandomVariates> copies(nthreads, *this);
+		std::vector<std::thread> threads;
+		for (unsigned int t = 1; t < nthreads; ++t)
+			threads.push_back(
+					std::thread(&RandomVariates::fillUniform01, &copies[t], out,
+							t * chunk, t + 1 < nthreads ? (t + 1) * chunk : n));
+		copies[0].fillUniform01(out, 0, chunk);
+		for (unsigned int t = 1; t < nthreads; ++t)
+			threads[t - 1].join();
+		Engine::operator=(copies.back());
+#ifdef MYRNG_STATS
+		stats_.words += n;
+		stats_.calls[Stats::UNIFORM01] += n;
+#endif
 	}
 
 	/**
@@ -77,6 +284,7 @@ public:
 	 */
 	double FromTo(double from, double to)
 	{
+		MYRNG_COUNT(stats_.calls[Stats::FROMTO]);
 		return from + (to - from) * Uniform01();
 	}
 
@@ -95,6 +303,9 @@ public:
 	template<class T>
 	T Dice(T faces = 6)
 	{
+		MYRNG_COUNT(stats_.calls[Stats::DICE]);
+		if (static_cast<uint64_t>(faces) > 0xffffffffULL)
+			return 1 + static_cast<T>(uniformInt(faces - 1));
 		return (1 + static_cast<T> (Uniform01() * faces));
 	}
 
@@ -111,12 +322,17 @@ public:
 	 * \endcode
 	 * \param from is the lower bound.
 	 * \param to is the upper bound.
+	 * Ranges of more than 2^32 integers are drawn exactly from 64 random
+	 * bits, see Uniform01_53(), so that every integer can occur.
 	 * \return An integer number in the discrete interval [from,from+1,...,to].
 	 * @see Dice()
 	 */
 	template<class T>
 	T IntFromTo(T from, T to)
 	{
+		MYRNG_COUNT(stats_.calls[Stats::INTFROMTO]);
+		if (static_cast<uint64_t>(to - from) > 0xffffffffULL)
+			return from + static_cast<T>(uniformInt(to - from));
 		return from + static_cast<T>((to - from + 1) * Uniform01());
 	}
 
@@ -134,12 +350,172 @@ public:
 	 * interval (0,1).
 	 * \return true if Uniform01() <= chance \n
 	 *         false if Uniform01() > chance
+	 * @see FairChance() for a fair coin flip from the bit buffer
 	 */
 	bool Chance(double chance = 0.5)
 	{
+		MYRNG_COUNT(stats_.calls[Stats::CHANCE]);
 		return (Uniform01() <= chance);
 	}
 
+	/**
+	 * Returns true with probability 1/2.
+	 *
+	 * A fair coin flip served from the bit buffer, see RandomBit(). Unlike
+	 * Chance() without argument, it uses one raw number for 32 (or 64)
+	 * flips.
+	 */
+	bool FairChance()
+	{
+		MYRNG_COUNT(stats_.calls[Stats::CHANCE]);
+		return RandomBit();
+	}
+
+	/**
+	 * Draw @p n outcomes of Chance() with the probabilities @p p[i] into
+	 * a bit mask.
+	 *
+	 * Bit i % 64 of mask[i / 64] is set if outcome i is true; the unused
+	 * bits of the last word are cleared. The outcomes are the same as those
+	 * of @p n calls of Chance(p[i]), but they are packed without a branch
+	 * per element, and consumers can iterate over the set bits with
+	 * popcount and count trailing zeros instead of branching on every
+	 * outcome, which mispredicts for probabilities far from 0 and 1.
+	 * Example:
+	 * \code
+	 * std::vector<uint64_t> dies((agents + 63) / 64);
+	 * rng.Chances(&mortality[0], agents, &dies[0]);
+	 * for (std::size_t w = 0; w < dies.size(); ++w)
+	 *     for (uint64_t b = dies[w]; b; b &= b - 1)
+	 *         kill(64 * w + __builtin_ctzll(b));
+	 * \endcode
+	 * \param p probabilities of the @p n outcomes
+	 * \param n number of outcomes
+	 * \param mask receives (n + 63) / 64 words
+	 */
+	void Chances(const double* p, std::size_t n, uint64_t* mask)
+	{
+		countChances(n);
+		for (std::size_t i = 0; i < n; i += 64)
+		{
+			const std::size_t m = n - i < 64 ? n - i : 64;
+			uint64_t w = 0;
+			for (std::size_t k = 0; k < m; ++k)
+				w |= static_cast<uint64_t>(Engine::canonical((*this)())
+						<= p[i + k]) << k;
+			mask[i / 64] = w;
+		}
+	}
+
+	/**
+	 * Draw @p n outcomes of Chance(p) with the same probability @p p into a
+	 * bit mask, see Chances(const double*, std::size_t, uint64_t*).
+	 *
+	 * The probability is converted once into a threshold for the raw
+	 * numbers, so that each outcome costs an integer comparison.
+	 */
+	void Chances(double p, std::size_t n, uint64_t* mask)
+	{
+		countChances(n);
+		const result_type t = chanceThreshold(p);
+		const uint64_t any = Engine::canonical(Engine::min()) <= p ? ~0ULL : 0;
+		for (std::size_t i = 0; i < n; i += 64)
+		{
+			const std::size_t m = n - i < 64 ? n - i : 64;
+			uint64_t w = 0;
+			for (std::size_t k = 0; k < m; ++k)
+				w |= static_cast<uint64_t>((*this)() <= t) << k;
+			mask[i / 64] = w & any;
+		}
+	}
+
+	/**
+	 * Draw @p n outcomes of Chance(p[i]) into a byte mask.
+	 *
+	 * Like Chances(const double*, std::size_t, uint64_t*), but out[i] is 1
+	 * if outcome i is true and 0 otherwise, e.g. to multiply with per-agent
+	 * quantities.
+	 */
+	void Chances(const double* p, std::size_t n, uint8_t* out)
+	{
+		countChances(n);
+		for (std::size_t i = 0; i < n; ++i)
+			out[i] = Engine::canonical((*this)()) <= p[i];
+	}
+
+	/**
+	 * Draw @p n outcomes of Chance(p) with the same probability @p p into a
+	 * byte mask, see Chances(double, std::size_t, uint64_t*).
+	 */
+	void Chances(double p, std::size_t n, uint8_t* out)
+	{
+		countChances(n);
+		const result_type t = chanceThreshold(p);
+		const uint8_t any = Engine::canonical(Engine::min()) <= p;
+		for (std::size_t i = 0; i < n; ++i)
+			out[i] = ((*this)() <= t) & any;
+	}
+
+	/**
+	 * A single random bit.
+	 *
+	 * The bits are served from a buffered raw number of the engine, which
+	 * is only replaced when all of its bits have been used. Drawing a bit
+	 * thus costs a shift most of the time and one engine call every 32 (or
+	 * 64) bits.
+	 * Example:
+	 * \code
+	 *   int spin = rng.RandomBit() ? 1 : -1;
+	 * \endcode
+	 * \return true or false with probability 1/2 each
+	 */
+	bool RandomBit()
+	{
+		MYRNG_COUNT(stats_.calls[Stats::RANDOMBIT]);
+		if (bit_count == 0)
+		{
+			bit_buffer = (*this)();
+			bit_count = DIGITS;
+		}
+		bool b = bit_buffer & 1;
+		bit_buffer >>= 1;
+		--bit_count;
+		return b;
+	}
+
+	/**
+	 * @p k random bits.
+	 *
+	 * Takes the bits from the same buffer as RandomBit(). If fewer than
+	 * @p k bits are left, they are completed with bits of a new raw number.
+	 * Example:
+	 * \code
+	 *   unsigned int neighbour = rng.RandomBits(2); // one of 4 directions
+	 * \endcode
+	 * \param k number of bits, between 1 and the number of bits of a raw
+	 * number of the engine
+	 * \return a number uniformly distributed on [0, 2^k-1]
+	 */
+	result_type RandomBits(unsigned int k)
+	{
+		assert(k >= 1 && k <= DIGITS);
+		MYRNG_COUNT(stats_.calls[Stats::RANDOMBITS]);
+		result_type r;
+		if (k <= bit_count)
+		{
+			r = bit_buffer & lowBits(k);
+			bit_buffer = k < DIGITS ? bit_buffer >> k : 0;
+			bit_count -= k;
+			return r;
+		}
+		const unsigned int need = k - bit_count;
+		const result_type y = (*this)();
+		r = bit_buffer | ((y & lowBits(need)) << bit_count);
+		bit_buffer = need < DIGITS ? y >> need : 0;
+		bit_count = DIGITS - need;
+		return r;
+	}
+
 	/**
 	 * Choose between n choices numbered 0,1,...n-1.
 	 *
@@ -159,6 +535,7 @@ public:
 	template<class T>
 	T Choices(double* prob, T numberOfChoices)
 	{
+		MYRNG_COUNT(stats_.calls[Stats::CHOICES]);
 		T ret = 0;
 		double x = Uniform01();
 		while (x > 0 && numberOfChoices > 0)
@@ -186,6 +563,7 @@ public:
 	 */
 	double Normal01Polar()
 	{
+		MYRNG_COUNT(stats_.calls[Stats::NORMAL01POLAR]);
 		if (polar_hasvariate)
 		{
 			polar_hasvariate = false;
@@ -197,6 +575,7 @@ public:
 			double W = 2;
 			while (W > 1)
 			{
+				MYRNG_COUNT(stats_.polarTries);
 				U1 = Uniform01();
 				U2 = Uniform01();
 				V1 = 2.0 * U1 - 1.0;
@@ -229,9 +608,59 @@ public:
 	 */
 	double GaussianPolar(double mean, double variance)
 	{
+		MYRNG_COUNT(stats_.calls[Stats::GAUSSIANPOLAR]);
 		return mean + sqrt(variance) * Normal01Polar();
 	}
 
+	/**
+	 * Normal distribution truncated to the interval [a,b].
+	 *
+	 * Draws from \f$ N(\mu,\sigma^2) \f$ conditioned on \f$ a \le x \le b \f$.
+	 * With the standardised bounds \f$ \alpha=(a-\mu)/\sigma \f$ and
+	 * \f$ \beta=(b-\mu)/\sigma \f$, one of three rejection methods is chosen
+	 * as in C. P. Robert, "Simulation of truncated normal variables",
+	 * Statistics and Computing 5, 121 (1995):
+	 * - Normal01Polar() variates, or their absolute values for a one-sided
+	 *   interval near the mean, if the interval holds enough of the mass;
+	 * - a uniform proposal on \f$ [\alpha,\beta] \f$ if the interval is
+	 *   narrow;
+	 * - an exponential proposal shifted to \f$ \alpha \f$ with the optimal
+	 *   rate if the interval lies in a tail.
+	 *
+	 * At least about half of the candidates are accepted for any interval,
+	 * even far out in the tails, where rejection from GaussianPolar() would
+	 * almost never succeed. Either bound may be infinite.
+	 * Example:
+	 * \code
+	 * // latent variable of a probit model with observation y = 1
+	 * double z = rng.TruncatedNormal(eta, 1., 0., INFINITY);
+	 * \endcode
+	 * \param mu mean of the normal distribution
+	 * \param sigma standard deviation, has to be greater than 0
+	 * \param a lower bound
+	 * \param b upper bound, not less than @p a
+	 * \return A random number \f$ x \sim N(\mu,\sigma^2) \f$ with
+	 * \f$ a \le x \le b \f$.
+	 */
+	double TruncatedNormal(double mu, double sigma, double a, double b)
+	{
+		assert(sigma > 0 && a <= b);
+		MYRNG_COUNT(stats_.calls[Stats::TRUNCATEDNORMAL]);
+		double lo = (a - mu) / sigma, hi = (b - mu) / sigma;
+		if (lo <= 0 && hi >= 0)
+			return mu + sigma * truncatedNormalCentral(lo, hi);
+		// mirror a lower tail to the upper one
+		const bool mirror = hi < 0;
+		if (mirror)
+		{
+			const double t = lo;
+			lo = -hi;
+			hi = -t;
+		}
+		const double z = truncatedNormalTail(lo, hi);
+		return mu + sigma * (mirror ? -z : z);
+	}
+
 	/**
 	 * Exponential distribution.
 	 *
@@ -254,10 +683,107 @@ public:
 	double Exponential(double mean)
 	{
 		assert(mean > 0);
+		MYRNG_COUNT(stats_.calls[Stats::EXPONENTIAL]);
 		double U = Uniform01();
 		return -mean * log(U);
 	}
 
+	/**
+	 * Uniform distribution on the interval [0,1) in single precision.
+	 *
+	 * Uses the 24 most significant bits of one raw number of the engine,
+	 * i.e. all values \f$ k/2^{24} \f$ with \f$ k=0,\dots,2^{24}-1 \f$ are
+	 * equally likely. In particular 0 occurs with probability \f$ 2^{-24} \f$.
+	 * \return Uniformly distributed random number \f$ u \sim U[0,1). \f$
+	 */
+	float Uniform01f()
+	{
+		MYRNG_COUNT(stats_.calls[Stats::UNIFORM01F]);
+		return bits24() * (1.0f / 16777216.0f);
+	}
+
+	/**
+	 * Fill @p out with @p n numbers from Uniform01f().
+	 */
+	void Uniform01f(float* out, std::size_t n)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+			out[i] = Uniform01f();
+	}
+
+	/**
+	 * Normal(0,1) distribution with polar method in single precision.
+	 *
+	 * Same algorithm as Normal01Polar(), computed in float from 24-bit
+	 * uniforms. The second variate of each pair is cached separately from
+	 * the one of Normal01Polar().
+	 * \return A gaussian distributed random number \f$ u\sim N(0,1) \f$.
+	 */
+	float Normal01f()
+	{
+		MYRNG_COUNT(stats_.calls[Stats::NORMAL01F]);
+		if (polarf_hasvariate)
+		{
+			polarf_hasvariate = false;
+			return polarf_variate;
+		}
+		float V1, V2;
+		float Y = polarf(V1, V2);
+		polarf_hasvariate = true;
+		polarf_variate = V1 * Y;
+		return V2 * Y;
+	}
+
+	/**
+	 * Fill @p out with @p n numbers from Normal01f().
+	 *
+	 * Gives the same numbers as @p n calls of Normal01f(), but generates
+	 * them in pairs without going through the cache.
+	 */
+	void Normal01f(float* out, std::size_t n)
+	{
+		std::size_t i = 0;
+		if (n > 0 && polarf_hasvariate)
+			out[i++] = Normal01f();
+		for (; i + 1 < n; i += 2)
+		{
+			MYRNG_COUNT(stats_.calls[Stats::NORMAL01F]);
+			MYRNG_COUNT(stats_.calls[Stats::NORMAL01F]);
+			float V1, V2;
+			float Y = polarf(V1, V2);
+			out[i] = V2 * Y;
+			out[i + 1] = V1 * Y;
+		}
+		if (i < n)
+			out[i] = Normal01f();
+	}
+
+	/**
+	 * Exponential distribution in single precision.
+	 *
+	 * Uses the logarithm method with a 24-bit uniform, see Exponential().
+	 * \param mean has to be greater than 0.
+	 * \return An exponential distributed random number
+	 * \f$ u\sim Exponential(mean) \f$.
+	 */
+	float Exponentialf(float mean)
+	{
+		assert(mean > 0);
+		MYRNG_COUNT(stats_.calls[Stats::EXPONENTIALF]);
+		// 1-U is in (0,1], so the logarithm is finite
+		float U = 1.0f - bits24() * (1.0f / 16777216.0f);
+		return -mean * std::log(U);
+	}
+
+	/**
+	 * Fill @p out with @p n numbers from Exponentialf(@p mean).
+	 */
+	void Exponentialf(float* out, std::size_t n, float mean)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+			out[i] = Exponentialf(mean);
+	}
+
 	/**
 	 * Gamma distribution.
 	 *
@@ -270,6 +796,7 @@ public:
 	 */
 	double Gamma(double shape, double scale)
 	{
+		MYRNG_COUNT(stats_.calls[Stats::GAMMA]);
 		double d, c, x, v, u, alpha;
 		if (shape < 1)
 			alpha = shape + 1.;
@@ -280,6 +807,7 @@ public:
 
 		do
 		{
+			MYRNG_COUNT(stats_.gammaTries);
 			do
 			{
 				x = Normal01Polar();
@@ -309,16 +837,797 @@ public:
 	 */
 	double Beta(double shape1, double shape2)
 	{
+		MYRNG_COUNT(stats_.calls[Stats::BETA]);
 		double Y1 = Gamma(shape1, 1.0);
 		double Y2 = Gamma(shape2, 1.0);
 
 		return Y1 / (Y1 + Y2);
 	}
 
+	/**
+	 * Binomial distribution.
+	 *
+	 * The number of successes in @p n independent trials with success
+	 * probability @p p, drawn in constant expected time. If
+	 * \f$ n\min(p,1-p) < 10 \f$ the distribution function is inverted by a
+	 * sequential search from 0, which takes \f$ O(np) \f$ steps. Otherwise
+	 * the transformed rejection method with squeeze BTRS of W. Hormann, "The
+	 * generation of binomial random variates", J. Stat. Comput. Simul. 46,
+	 * 101 (1993) is used, which accepts almost every candidate. Its setup is
+	 * cached for the last parameters, as for Zipf().
+	 * \param n number of trials
+	 * \param p success probability in [0,1]
+	 * \return An integer in [0,n].
+	 */
+	template<class T>
+	T Binomial(T n, double p)
+	{
+		assert(p >= 0 && p <= 1);
+		MYRNG_COUNT(stats_.calls[Stats::BINOMIAL]);
+		// draw the number of the less likely outcome
+		const bool flip = p > 0.5;
+		const double q = flip ? 1. - p : p;
+		const double m = static_cast<double>(n);
+		const double k = m * q < 10. ? binomialInversion(m, q)
+				: binomialBTRS(m, q);
+		return static_cast<T>(flip ? m - k : k);
+	}
+
+	/**
+	 * Multinomial distribution.
+	 *
+	 * Distributes @p n individuals among @p k categories, category i having
+	 * probability prob[i], and writes the numbers per category to
+	 * @p counts. The counts are drawn one category after the other from the
+	 * conditional binomial distributions, so the cost is O(k) calls of
+	 * Binomial() independent of @p n, instead of @p n calls of Choices().
+	 * Example:
+	 * \code
+	 * // offspring genotypes of the next generation
+	 * unsigned long counts[3];
+	 * rng.Multinomial(N, freq, 3, counts);
+	 * \endcode
+	 * \param n number of individuals
+	 * \param prob probabilities of the categories, which have to sum to 1
+	 * up to rounding
+	 * \param k number of categories
+	 * \param counts receives @p k counts that sum to @p n
+	 */
+	template<class T>
+	void Multinomial(T n, const double* prob, std::size_t k, T* counts)
+	{
+		assert(k >= 1);
+		MYRNG_COUNT(stats_.calls[Stats::MULTINOMIAL]);
+		// the last category with a positive probability takes the rest, so
+		// that rounding in rest cannot leave individuals to the zero tail
+		std::size_t last = k - 1;
+		while (last > 0 && prob[last] <= 0.)
+			counts[last--] = 0;
+		double rest = 0.; // probability of categories i to last
+		for (std::size_t i = 0; i <= last; ++i)
+			rest += prob[i];
+		for (std::size_t i = 0; i < last; ++i)
+		{
+			if (n == 0 || rest <= 0.)
+				counts[i] = 0;
+			else
+			{
+				const double p = prob[i] / rest;
+				counts[i] = Binomial(n, p < 1. ? p : 1.);
+				n -= counts[i];
+			}
+			rest -= prob[i];
+		}
+		counts[last] = n;
+	}
+
+	/**
+	 * Dirichlet distribution.
+	 *
+	 * Writes @p k proportions that sum to 1 to @p out, obtained by
+	 * normalising Gamma(alpha[i], 1) variates. They are computed as
+	 * logarithms, so that small shapes, whose Gamma variates underflow,
+	 * still give proportions that sum to 1.
+	 * \param alpha shape parameters, have to be greater than 0
+	 * \param k number of categories
+	 * \param out receives the proportions
+	 */
+	void Dirichlet(const double* alpha, std::size_t k, double* out)
+	{
+		assert(k >= 1);
+		MYRNG_COUNT(stats_.calls[Stats::DIRICHLET]);
+		double top = -std::numeric_limits<double>::infinity();
+		for (std::size_t i = 0; i < k; ++i)
+		{
+			assert(alpha[i] > 0);
+			// for shapes below 1, Gamma() multiplies by U^(1/alpha)
+			if (alpha[i] < 1.)
+				out[i] = std::log(Gamma(alpha[i] + 1., 1.))
+						+ std::log(Uniform01()) / alpha[i];
+			else
+				out[i] = std::log(Gamma(alpha[i], 1.));
+			if (out[i] > top)
+				top = out[i];
+		}
+		double sum = 0.;
+		for (std::size_t i = 0; i < k; ++i)
+			sum += out[i] = std::exp(out[i] - top);
+		for (std::size_t i = 0; i < k; ++i)
+			out[i] /= sum;
+	}
+
+	/**
+	 * Uniformly distributed unit vector in three dimensions.
+	 *
+	 * Uses the method of G. Marsaglia, "Choosing a point from the surface of
+	 * a sphere", Ann. Math. Stat. 43, 645 (1972): a point (u,v) uniform in
+	 * the unit disk, found by rejection from the square like in
+	 * Normal01Polar(), is mapped to the sphere without trigonometric
+	 * functions. On average 2.55 uniforms are drawn per vector.
+	 * Example:
+	 * \code
+	 *   // new direction of an active particle after tumbling
+	 *   rng.UnitVector3(p.ex, p.ey, p.ez);
+	 * \endcode
+	 */
+	void UnitVector3(double& x, double& y, double& z)
+	{
+		MYRNG_COUNT(stats_.calls[Stats::UNITVECTOR]);
+		double u, v, s;
+		do
+		{
+			u = 2.0 * Uniform01() - 1.0;
+			v = 2.0 * Uniform01() - 1.0;
+			s = u * u + v * v;
+		} while (s >= 1.0);
+		const double r = 2.0 * sqrt(1.0 - s);
+		x = u * r;
+		y = v * r;
+		z = 1.0 - 2.0 * s;
+	}
+
+	/**
+	 * Fill @p x, @p y and @p z with the components of @p n unit vectors
+	 * from UnitVector3().
+	 *
+	 * The candidates are drawn in blocks; the test and the mapping to the
+	 * sphere are then done in loops without branches, which the compiler
+	 * can vectorize. The vectors are the same as those of @p n calls of
+	 * UnitVector3().
+	 */
+	void UnitVectors3(double* x, double* y, double* z, std::size_t n)
+	{
+#ifdef MYRNG_STATS
+		stats_.calls[Stats::UNITVECTOR] += n;
+#endif
+		const std::size_t B = 256;
+		double u[B], v[B], s[B];
+		std::size_t done = 0;
+		while (done < n)
+		{
+			// never more candidates than vectors missing, so that no number
+			// is drawn beyond those of the scalar calls
+			const std::size_t m = n - done < B ? n - done : B;
+			for (std::size_t i = 0; i < m; ++i)
+			{
+				u[i] = Uniform01();
+				v[i] = Uniform01();
+			}
+			for (std::size_t i = 0; i < m; ++i)
+			{
+				u[i] = 2.0 * u[i] - 1.0;
+				v[i] = 2.0 * v[i] - 1.0;
+				s[i] = u[i] * u[i] + v[i] * v[i];
+			}
+			// keep the candidates inside the disk; k < n holds throughout
+			std::size_t k = done;
+			for (std::size_t i = 0; i < m; ++i)
+			{
+				x[k] = u[i];
+				y[k] = v[i];
+				z[k] = s[i];
+				k += s[i] < 1.0;
+			}
+			for (std::size_t j = done; j < k; ++j)
+			{
+				const double r = 2.0 * sqrt(1.0 - z[j]);
+				x[j] *= r;
+				y[j] *= r;
+				z[j] = 1.0 - 2.0 * z[j];
+			}
+			done = k;
+		}
+	}
+
+	/**
+	 * Uniformly distributed unit vector in @p d dimensions.
+	 *
+	 * Writes a point on the sphere \f$ S^{d-1} \f$ to x[0],...,x[d-1]. For
+	 * d = 3 this is UnitVector3(), otherwise a vector of @p d Normal01Polar()
+	 * variates is normalized.
+	 */
+	void UnitVector(double* x, unsigned int d)
+	{
+		assert(d > 0);
+		if (d == 3)
+		{
+			UnitVector3(x[0], x[1], x[2]);
+			return;
+		}
+		MYRNG_COUNT(stats_.calls[Stats::UNITVECTOR]);
+		double r2;
+		do
+		{
+			r2 = 0.0;
+			for (unsigned int k = 0; k < d; ++k)
+			{
+				x[k] = Normal01Polar();
+				r2 += x[k] * x[k];
+			}
+		} while (r2 == 0.0);
+		const double r = 1.0 / sqrt(r2);
+		for (unsigned int k = 0; k < d; ++k)
+			x[k] *= r;
+	}
+
+	/**
+	 * Fill @p out with @p n unit vectors from UnitVector() in
+	 * structure-of-arrays layout.
+	 *
+	 * Component @c k of vector @c i is stored in out[k * n + i], so
+	 * @p out has to hold @p n * @p d numbers. The normalization is done in
+	 * loops over the vectors, which the compiler can vectorize. The vectors
+	 * are the same as those of @p n calls of UnitVector().
+	 */
+	void UnitVectors(double* out, std::size_t n, unsigned int d)
+	{
+		assert(d > 0);
+		if (d == 3)
+		{
+			UnitVectors3(out, out + n, out + 2 * n, n);
+			return;
+		}
+#ifdef MYRNG_STATS
+		stats_.calls[Stats::UNITVECTOR] += n;
+#endif
+		const std::size_t B = 256;
+		double r[B];
+		for (std::size_t begin = 0; begin < n; begin += B)
+		{
+			const std::size_t m = n - begin < B ? n - begin : B;
+			double* const block = out + begin;
+			for (std::size_t i = 0; i < m; ++i)
+			{
+				double r2;
+				do
+				{
+					r2 = 0.0;
+					for (unsigned int k = 0; k < d; ++k)
+					{
+						const double c = Normal01Polar();
+						block[k * n + i] = c;
+						r2 += c * c;
+					}
+				} while (r2 == 0.0);
+				r[i] = 1.0 / sqrt(r2);
+			}
+			for (unsigned int k = 0; k < d; ++k)
+			{
+				double* const component = block + k * n;
+				for (std::size_t i = 0; i < m; ++i)
+					component[i] *= r[i];
+			}
+		}
+	}
+
+	/**
+	 * Uniformly distributed point in the @p d-dimensional unit ball.
+	 *
+	 * A unit vector from UnitVector() is scaled by \f$ U^{1/d} \f$, the
+	 * radius whose d-th power is uniform.
+	 */
+	void InBall(double* x, unsigned int d)
+	{
+		MYRNG_COUNT(stats_.calls[Stats::INBALL]);
+		UnitVector(x, d);
+		const double r = pow(Uniform01(), 1.0 / d);
+		for (unsigned int k = 0; k < d; ++k)
+			x[k] *= r;
+	}
+
+	/**
+	 * Fill @p out with @p n points from InBall() in structure-of-arrays
+	 * layout, see UnitVectors().
+	 *
+	 * All directions are drawn before the radii, so the points differ from
+	 * those of @p n calls of InBall().
+	 */
+	void InBalls(double* out, std::size_t n, unsigned int d)
+	{
+#ifdef MYRNG_STATS
+		stats_.calls[Stats::INBALL] += n;
+#endif
+		UnitVectors(out, n, d);
+		const std::size_t B = 256;
+		double r[B];
+		for (std::size_t begin = 0; begin < n; begin += B)
+		{
+			const std::size_t m = n - begin < B ? n - begin : B;
+			for (std::size_t i = 0; i < m; ++i)
+				r[i] = pow(Uniform01(), 1.0 / d);
+			for (unsigned int k = 0; k < d; ++k)
+			{
+				double* const component = out + k * n + begin;
+				for (std::size_t i = 0; i < m; ++i)
+					component[i] *= r[i];
+			}
+		}
+	}
+
+	/**
+	 * Zipf distribution on [1,2,...,n].
+	 *
+	 * Returns k with probability proportional to \f$ k^{-s} \f$. Uses the
+	 * rejection-inversion method of W. Hörmann and G. Derflinger, "Rejection-
+	 * inversion to generate variates from monotone discrete distributions",
+	 * ACM TOMACS 6, 3 (1996), 169-184. The expected number of uniforms per
+	 * variate is bounded independently of @p n, and no table is built.
+	 * Large values are accepted without the rejection test, which cannot be
+	 * evaluated accurately in double precision for them. Their probabilities
+	 * then follow the hat function, with a relative error of about
+	 * \f$ s(s+1)/(24k^2) \f$; the test is skipped from
+	 * \f$ k = \max(2^{20}, 10^6\sqrt{s(s+1)/24}) \f$ on, which keeps that
+	 * error below 10^-12 for every @p s. The
+	 * setup for the last pair of parameters is cached, so repeated calls with
+	 * the same @p s and @p n cost a few logarithms each.
+	 * Example:
+	 * \code
+	 *   // degree of a node in a scale-free network
+	 *   unsigned long degree = rng.Zipf(2.5, 1000000000UL);
+	 * \endcode
+	 * \param s exponent, has to be greater than 0
+	 * \param n number of elements, has to be at least 1
+	 * \return An integer in [1,n].
+	 */
+	template<class T>
+	T Zipf(double s, T n)
+	{
+		assert(s > 0 && n >= 1);
+		MYRNG_COUNT(stats_.calls[Stats::ZIPF]);
+		zipfSetup(s, static_cast<double>(n));
+		return static_cast<T>(zipfDraw());
+	}
+
+	/**
+	 * Zeta distribution, i.e. the Zipf distribution with infinitely many
+	 * elements.
+	 *
+	 * Returns k=1,2,... with probability \f$ k^{-s}/\zeta(s) \f$, using the
+	 * same rejection-inversion method as Zipf(). It is formulated in terms of
+	 * the tail integral of the hat function, which avoids the cancellation
+	 * of Zipf() with an infinite number of elements. Large values are
+	 * accepted without the rejection test, with the same relative error of
+	 * at most 10^-12 as for Zipf().
+	 * \param s exponent, has to be greater than 1
+	 * \return An integer-valued double, at least 1. For @p s close to 1
+	 * the variates may exceed the range of the integer types; they are
+	 * exact integers up to 2^53.
+	 */
+	double Zeta(double s)
+	{
+		assert(s > 1);
+		MYRNG_COUNT(stats_.calls[Stats::ZETA]);
+		if (s != zeta_s)
+		{
+			zeta_s = s;
+			zeta_g1 = zetaG(1.5) + 1.;
+			zeta_c = 2. - zetaGInverse(zetaG(2.5) + std::pow(2., -s));
+			zeta_noreject = zipfNoReject(s);
+		}
+		for (;;)
+		{
+			MYRNG_COUNT(stats_.zipfTries);
+			const double g = Uniform01() * zeta_g1;
+			const double x = zetaGInverse(g);
+			if (x == HUGE_VAL)
+				continue;
+			double k = std::floor(x + 0.5);
+			if (k < 1.)
+				k = 1.;
+			if (k - x <= zeta_c || k >= zeta_noreject
+					|| g <= zetaG(k + 0.5) + std::exp(-s * std::log(k)))
+				return k;
+		}
+	}
+
 private:
+	/// Jump to number @p begin and fill out[begin, end) as Uniform01()
+	void fillUniform01(double* out, std::size_t begin, std::size_t end)
+	{
+		Engine::discard(begin);
+		for (std::size_t i = begin; i < end; ++i)
+			out[i] = Engine::canonical(Engine::operator()());
+	}
+
+	/// Number of bits of a raw number
+	static const unsigned int DIGITS = std::numeric_limits<result_type>::digits;
+
+	/// Mask of the @p k lowest bits
+	static result_type lowBits(unsigned int k)
+	{
+		return k < DIGITS ? (result_type(1) << k) - 1 : ~result_type(0);
+	}
+
+	/// Lower bound of a one-sided interval below which TruncatedNormal()
+	/// prefers the absolute values of normal variates to exponential ones
+	static constexpr double TRUNCATED_NAIVE = 0.5;
+
+	/// Lower bound of the values accepted without the rejection test
+	static constexpr double ZIPF_NOREJECT = 1048576.;
+
+	/**
+	 * Smallest value accepted without the rejection test for exponent @p s.
+	 *
+	 * The hat function gives k the probability
+	 * \f$ k^{-s}(1 + s(s+1)/(24k^2) + O(k^{-4})) \f$, so its relative error
+	 * is kept below 10^-12 from here on.
+	 */
+	static double zipfNoReject(double s)
+	{
+		const double k = 1e6 * std::sqrt(s * (s + 1.) / 24.);
+		return k > ZIPF_NOREJECT ? k : ZIPF_NOREJECT;
+	}
+
+	/*
+	 * Helpers of the Zipf sampler, following the formulation of the
+	 * rejection-inversion method in Apache Commons RNG, which remains
+	 * accurate for s close to 1.
+	 */
+
+	/// log1p(x)/x, continuous at 0
+	static double zipfHelper1(double x)
+	{
+		if (std::fabs(x) > 1e-8)
+			return std::log1p(x) / x;
+		return 1. - x * (0.5 - x * (1. / 3. - 0.25 * x));
+	}
+
+	/// expm1(x)/x, continuous at 0
+	static double zipfHelper2(double x)
+	{
+		if (std::fabs(x) > 1e-8)
+			return std::expm1(x) / x;
+		return 1. + x * 0.5 * (1. + x * (1. / 3.) * (1. + 0.25 * x));
+	}
+
+	/// The hat function $ h(x)=x^{-s} $
+	double zipfH(double x) const
+	{
+		return std::exp(-zipf_s * std::log(x));
+	}
+
+	/// An antiderivative of h, $ (x^{1-s}-1)/(1-s) $
+	double zipfHIntegral(double x) const
+	{
+		const double logX = std::log(x);
+		return zipfHelper2((1. - zipf_s) * logX) * logX;
+	}
+
+	/// The inverse of zipfHIntegral()
+	double zipfHIntegralInverse(double x) const
+	{
+		double t = x * (1. - zipf_s);
+		if (t < -1.)
+			t = -1.; // limit x to the range of zipfHIntegral()
+		return std::exp(zipfHelper1(t) * x);
+	}
+
+	/// Compute the setup for exponent @p s and @p n elements unless cached
+	void zipfSetup(double s, double n)
+	{
+		if (s == zipf_s && n == zipf_n)
+			return;
+		zipf_s = s;
+		zipf_n = n;
+		zipf_hx1 = zipfHIntegral(1.5) - 1.;
+		zipf_hn = zipfHIntegral(n + 0.5);
+		zipf_c = 2. - zipfHIntegralInverse(zipfHIntegral(2.5) - zipfH(2.));
+		zipf_noreject = zipfNoReject(s);
+	}
+
+	/// Draw a Zipf variate with the cached setup
+	double zipfDraw()
+	{
+		for (;;)
+		{
+			MYRNG_COUNT(stats_.zipfTries);
+			const double u = zipf_hn + Uniform01() * (zipf_hx1 - zipf_hn);
+			const double x = zipfHIntegralInverse(u);
+			double k = std::floor(x + 0.5);
+			if (k < 1.)
+				k = 1.;
+			else if (k > zipf_n)
+				k = zipf_n;
+			if (k - x <= zipf_c || k >= zipf_noreject
+					|| u >= zipfHIntegral(k + 0.5) - zipfH(k))
+				return k;
+		}
+	}
+
+	/// Tail integral of the hat function of Zeta(), \f$ x^{1-s}/(s-1) \f$
+	double zetaG(double x) const
+	{
+		return std::exp((1. - zeta_s) * std::log(x)) / (zeta_s - 1.);
+	}
+
+	/// The inverse of zetaG()
+	double zetaGInverse(double g) const
+	{
+		return std::exp(-std::log((zeta_s - 1.) * g) / (zeta_s - 1.));
+	}
+
+	/// Standard normal truncated to [lo,hi] with lo <= 0 <= hi
+	double truncatedNormalCentral(double lo, double hi)
+	{
+		// normal variates are accepted more often than uniform proposals on
+		// intervals wider than sqrt(2 pi)
+		if (hi - lo >= 2.5066282746310002)
+			for (;;)
+			{
+				MYRNG_COUNT(stats_.truncatedTries);
+				const double z = Normal01Polar();
+				if (z >= lo && z <= hi)
+					return z;
+			}
+		for (;;)
+		{
+			MYRNG_COUNT(stats_.truncatedTries);
+			const double z = lo + (hi - lo) * Uniform01();
+			if (Uniform01() <= std::exp(-0.5 * z * z))
+				return z;
+		}
+	}
+
+	/// Standard normal truncated to [lo,hi] with 0 < lo
+	double truncatedNormalTail(double lo, double hi)
+	{
+		const double root = std::sqrt(lo * lo + 4.);
+		// Robert's bound below which the uniform proposal is accepted more
+		// often than the exponential one
+		const double narrow = 2. * 1.6487212707001282 / (lo + root)
+				* std::exp(0.25 * lo * (lo - root));
+		if (hi - lo < narrow)
+			for (;;)
+			{
+				MYRNG_COUNT(stats_.truncatedTries);
+				const double z = lo + (hi - lo) * Uniform01();
+				if (Uniform01() <= std::exp(-0.5 * (z - lo) * (z + lo)))
+					return z;
+			}
+		if (lo < TRUNCATED_NAIVE)
+			for (;;)
+			{
+				MYRNG_COUNT(stats_.truncatedTries);
+				const double z = std::fabs(Normal01Polar());
+				if (z >= lo && z <= hi)
+					return z;
+			}
+		const double lambda = 0.5 * (lo + root);
+		for (;;)
+		{
+			MYRNG_COUNT(stats_.truncatedTries);
+			const double z = lo - std::log(1. - Uniform01()) / lambda;
+			if (z <= hi
+					&& Uniform01() <= std::exp(-0.5 * (z - lambda) * (z - lambda)))
+				return z;
+		}
+	}
+
+	/// Binomial(n,p) with p <= 1/2 by sequential search from 0
+	double binomialInversion(double n, double p)
+	{
+		const double q = 1. - p, s = p / q, a = (n + 1.) * s;
+		const double r0 = std::exp(n * std::log1p(-p)); // P(0)
+		for (;;)
+		{
+			double u = Uniform01(), r = r0, k = 0.;
+			// restart if the rounding errors of the recurrence exhaust r
+			while (u > r && k < n)
+			{
+				u -= r;
+				++k;
+				r *= a / k - s;
+			}
+			if (u <= r)
+				return k;
+		}
+	}
+
+	/// Setup of binomialBTRS() for the parameters @p n and @p p
+	void binomialSetup(double n, double p)
+	{
+		if (n == binomial_n && p == binomial_p)
+			return;
+		binomial_n = n;
+		binomial_p = p;
+		const double q = 1. - p, spq = std::sqrt(n * p * q);
+		binomial_b = 1.15 + 2.53 * spq;
+		binomial_a = -0.0873 + 0.0248 * binomial_b + 0.01 * p;
+		binomial_c = n * p + 0.5;
+		binomial_vr = 0.92 - 4.2 / binomial_b;
+		binomial_alpha = (2.83 + 5.1 / binomial_b) * spq;
+		binomial_lpq = std::log(p / q);
+		binomial_m = std::floor((n + 1.) * p);
+		binomial_h = std::lgamma(binomial_m + 1.)
+				+ std::lgamma(n - binomial_m + 1.);
+	}
+
+	/// Binomial(n,p) with p <= 1/2 and n p >= 10 by Hormann's BTRS
+	double binomialBTRS(double n, double p)
+	{
+		binomialSetup(n, p);
+		for (;;)
+		{
+			MYRNG_COUNT(stats_.binomialTries);
+			const double u = Uniform01() - 0.5;
+			double v = Uniform01();
+			const double us = 0.5 - std::fabs(u);
+			const double k = std::floor(
+					(2. * binomial_a / us + binomial_b) * u + binomial_c);
+			if (k < 0. || k > n)
+				continue;
+			// squeeze
+			if (us >= 0.07 && v <= binomial_vr)
+				return k;
+			v = std::log(v * binomial_alpha
+					/ (binomial_a / (us * us) + binomial_b));
+			if (v <= binomial_h - std::lgamma(k + 1.) - std::lgamma(n - k + 1.)
+					+ (k - binomial_m) * binomial_lpq)
+				return k;
+		}
+	}
+
+	/// Count @p n calls of Chance() made by a batch
+	void countChances(std::size_t n)
+	{
+#ifdef MYRNG_STATS
+		stats_.calls[Stats::CHANCE] += n;
+#else
+		(void) n;
+#endif
+	}
+
+	/**
+	 * Largest raw number y with canonical(y) <= p, or min() if there is
+	 * none. canonical() is monotonic, so a bisection finds it.
+	 */
+	result_type chanceThreshold(double p) const
+	{
+		result_type lo = Engine::min(), hi = Engine::max();
+		if (Engine::canonical(hi) <= p)
+			return hi;
+		if (!(Engine::canonical(lo) <= p))
+			return lo;
+		// canonical(lo) <= p < canonical(hi)
+		while (hi - lo > 1)
+		{
+			const result_type mid = lo + (hi - lo) / 2;
+			if (Engine::canonical(mid) <= p)
+				lo = mid;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	/// 64 random bits from one raw number, or two of a 32-bit engine
+	uint64_t bits64()
+	{
+		if (DIGITS >= 64)
+			return (*this)();
+		const uint64_t hi = (*this)();
+		return (hi << 32) | (*this)();
+	}
+
+	/// High word of the 128-bit product of @p a and @p b; the low one in @p lo
+	static uint64_t mulhi(uint64_t a, uint64_t b, uint64_t& lo)
+	{
+		const uint64_t a0 = a & 0xffffffffULL, a1 = a >> 32;
+		const uint64_t b0 = b & 0xffffffffULL, b1 = b >> 32;
+		const uint64_t p01 = a0 * b1, p10 = a1 * b0;
+		const uint64_t mid = ((a0 * b0) >> 32) + (p01 & 0xffffffffULL)
+				+ (p10 & 0xffffffffULL);
+		lo = a * b;
+		return a1 * b1 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+	}
+
+	/**
+	 * Uniform integer in [0,span] from 64 random bits.
+	 *
+	 * The multiply-and-reject method of D. Lemire, "Fast random integer
+	 * generation in an interval", ACM TOMACS 29, 1 (2019): without bias and
+	 * with a rejection probability below span / 2^64.
+	 */
+	uint64_t uniformInt(uint64_t span)
+	{
+		if (span == ~uint64_t(0))
+			return bits64();
+		const uint64_t range = span + 1;
+		uint64_t lo;
+		uint64_t hi = mulhi(bits64(), range, lo);
+		if (lo < range)
+		{
+			const uint64_t threshold = (0 - range) % range;
+			while (lo < threshold)
+				hi = mulhi(bits64(), range, lo);
+		}
+		return hi;
+	}
+
+	/// The 24 most significant bits of a raw number
+	uint32_t bits24()
+	{
+		return static_cast<uint32_t>((*this)()
+				>> (std::numeric_limits<result_type>::digits - 24));
+	}
+
+	/**
+	 * Draw a pair for the polar method in single precision.
+	 *
+	 * Stores the point in the unit disk in @p V1 and @p V2 and returns the
+	 * factor transforming both coordinates into normal variates.
+	 */
+	float polarf(float& V1, float& V2)
+	{
+		float W;
+		do
+		{
+			MYRNG_COUNT(stats_.polarTries);
+			V1 = 2.0f * (bits24() * (1.0f / 16777216.0f)) - 1.0f;
+			V2 = 2.0f * (bits24() * (1.0f / 16777216.0f)) - 1.0f;
+			W = V1 * V1 + V2 * V2;
+		} while (W > 1.0f || W == 0.0f);
+		return std::sqrt((-2.0f * std::log(W)) / W);
+	}
+
 	// Polar Method variables
 	bool polar_hasvariate; // A random number is still stored
 	double polar_variate; // The random number
+	bool polarf_hasvariate; // A single precision number is still stored
+	float polarf_variate; // The single precision number
+
+	// Bit buffer variables
+	result_type bit_buffer; // Unused bits of a raw number, lowest first
+	unsigned int bit_count; // Number of unused bits
+
+	// Zipf setup for the last parameters
+	double zipf_s; // Exponent
+	double zipf_n; // Number of elements
+	double zipf_hx1; // zipfHIntegral(1.5) - h(1)
+	double zipf_hn; // zipfHIntegral(n + 0.5)
+	double zipf_c; // Squeeze: values k with k - x <= zipf_c are accepted
+	double zipf_noreject; // Values from here on are accepted
+
+	// Zeta setup for the last exponent
+	double zeta_s; // Exponent
+	double zeta_g1; // zetaG(1.5) + h(1)
+	double zeta_c; // Squeeze as for Zipf
+	double zeta_noreject; // As for Zipf
+
+	// Binomial setup of the rejection method for the last parameters
+	double binomial_n; // Number of trials
+	double binomial_p; // Success probability, at most 1/2
+	double binomial_a, binomial_b, binomial_c; // Hat function
+	double binomial_vr; // Squeeze: candidates with v <= binomial_vr are accepted
+	double binomial_alpha; // Scale of the hat function
+	double binomial_lpq; // log(p / (1 - p))
+	double binomial_m; // Mode
+	double binomial_h; // log(m! (n - m)!)
+
+	// declared without -DMYRNG_STATS as well, so that the layout does not
+	// depend on the flag, e.g. of the global rng of libmyrngMT
+	Stats stats_; // instrumentation counters
+	unsigned long long refills0; // refills of the engine at resetStats()
 
 };
 
@@ -0,0 +1,206 @@
+/**
+ * Engine adapter recording the random stream to a file
+ *
+ * @file RecordEngine.h
+ */
+
+#ifndef RECORDENGINE_H_
+#define RECORDENGINE_H_
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+namespace myrng
+{
+
+/**
+ * Header of a file written by RecordEngine.
+ *
+ * The header is followed by the recorded raw numbers in native byte order.
+ * Its size is a multiple of 8 bytes, so that the values are properly
+ * aligned when the file is mapped into memory.
+ */
+struct RecordHeader
+{
+	char magic[8]; ///< "MYRNGREC"
+	uint32_t byteorder; ///< 0x01020304 in the byte order of the writer
+	uint32_t valuesize; ///< size of a recorded value in bytes
+	char engine[32]; ///< name of the engine, padded with zeros
+
+	/// Header describing values of @p valuesize bytes of the engine
+	/// @p name on this platform
+	static RecordHeader native(uint32_t valuesize, const char* name)
+	{
+		RecordHeader h;
+		std::memcpy(h.magic, "MYRNGREC", 8);
+		h.byteorder = 0x01020304;
+		h.valuesize = valuesize;
+		std::memset(h.engine, 0, sizeof h.engine);
+		std::strncpy(h.engine, name, sizeof h.engine - 1);
+		return h;
+	}
+	/// Check whether values of @p valuesize bytes of the engine @p name
+	/// following this header can be used directly
+	bool compatible(uint32_t valuesize, const char* name) const
+	{
+		RecordHeader h = native(valuesize, name);
+		return std::memcmp(magic, h.magic, 8) == 0 && byteorder == h.byteorder
+				&& valuesize == h.valuesize
+				&& std::memcmp(engine, h.engine, sizeof engine) == 0;
+	}
+};
+
+/**
+ * Engine adapter that tees the output of @p Engine into a binary file.
+ *
+ * The raw numbers of @p Engine are recorded and passed on unchanged, so a simulation behaves exactly as
+ * with @p Engine itself. Numbers produced by fill() and skipped by discard()
+ * are recorded as well. The recorded file can be replayed with
+ * ReplayEngine<Engine>. Write errors, e.g. on a full disk, are reported by
+ * stop() and failed().
+ * Example:
+ * @code
+ * myrng::RandomVariates<myrng::RecordEngine<myrng::MTEngine> > rng;
+ * rng.Seed(42);
+ * rng.record("run42.rec");
+ * simulate(rng);
+ * if (!rng.stop())
+ *     std::cerr << "run42.rec is incomplete\n";
+ * @endcode
+ */
+template<class Engine>
+class RecordEngine: public Engine
+{
+public:
+	typedef typename Engine::result_type result_type;
+
+	RecordEngine() :
+			file(0), n(0), error(false)
+	{
+	}
+	/**
+	 * Start recording into @p filename.
+	 *
+	 * An existing file is overwritten. A recording in progress is finished
+	 * first.
+	 * @return false if the file cannot be opened
+	 */
+	bool record(const char* filename)
+	{
+		stop();
+		error = false;
+		file = std::fopen(filename, "wb");
+		if (!file)
+			return false;
+		RecordHeader h = RecordHeader::native(sizeof(result_type),
+				Engine::getName());
+		if (std::fwrite(&h, sizeof h, 1, file) != 1)
+		{
+			std::fclose(file);
+			file = 0;
+			return false;
+		}
+		return true;
+	}
+	/**
+	 * Finish the recording and close the file.
+	 * @return false if writing the recording has failed, see failed()
+	 */
+	bool stop()
+	{
+		if (file)
+		{
+			flush();
+			if (std::fclose(file) != 0)
+				error = true;
+			file = 0;
+		}
+		return !error;
+	}
+	/**
+	 * Check whether writing the current or last recording has failed, e.g.
+	 * because the disk is full. The recorded file is then incomplete.
+	 */
+	bool failed() const
+	{
+		return error;
+	}
+	/**
+	 * Check whether a recording is in progress.
+	 */
+	bool recording() const
+	{
+		return file != 0;
+	}
+	/// Produce a raw random number and record it.
+	result_type operator()()
+	{
+		result_type x = Engine::operator()();
+		if (file)
+			put(x);
+		return x;
+	}
+	/**
+	 * Produce @p count raw numbers into @p out and record them.
+	 */
+	void fill(result_type* out, std::size_t count)
+	{
+		Engine::fill(out, count);
+		if (file)
+			for (std::size_t i = 0; i < count; ++i)
+				put(out[i]);
+	}
+	/**
+	 * Skip the next @p z raw numbers.
+	 *
+	 * While recording, the numbers are drawn and recorded one at a time, so
+	 * that a replay stays in step.
+	 */
+	void discard(unsigned long long z)
+	{
+		if (!file)
+			Engine::discard(z);
+		else
+			while (z--)
+				put(Engine::operator()());
+	}
+
+protected:
+	~RecordEngine()
+	{
+		stop();
+	}
+
+private:
+	RecordEngine(const RecordEngine&);
+	RecordEngine& operator=(const RecordEngine&);
+
+	void put(result_type x)
+	{
+		buf[n++] = x;
+		if (n == BUFSIZE)
+			flush();
+	}
+
+	void flush()
+	{
+		if (std::fwrite(buf, sizeof(result_type), n, file)
+				!= static_cast<std::size_t>(n))
+			error = true;
+		n = 0;
+	}
+
+	enum
+	{
+		BUFSIZE = 1024 ///< number of values written at once
+	};
+	std::FILE* file; ///< output file or 0 if not recording
+	result_type buf[BUFSIZE]; ///< values not yet written
+	int n; ///< number of values in buf
+	bool error; ///< writing the recording has failed
+};
+
+} /* namespace myrng */
+#endif /* RECORDENGINE_H_ */
@@ -0,0 +1,222 @@
+/**
+ * Engine replaying a recorded random stream
+ *
+ * @file ReplayEngine.h
+ */
+
+#ifndef REPLAYENGINE_H_
+#define REPLAYENGINE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "RecordEngine.h"
+
+namespace myrng
+{
+
+/**
+ * Replay of a stream recorded by RecordEngine<Engine>.
+ *
+ * The file is mapped into memory and the raw numbers are served directly
+ * from the mapping, so generating a number costs a single load. They are
+ * converted to doubles in the same way as by @p Engine itself. Use it to
+ * reproduce the exact random input of a run under a debugger or profiler,
+ * or to measure a model without the cost of random number generation.
+ * When the end of the recording is reached, the stream starts over.
+ * Example:
+ * @code
+ * myrng::RandomVariates<myrng::ReplayEngine<myrng::MTEngine> > rng;
+ * if (!rng.open("run42.rec"))
+ *     return 1;
+ * simulate(rng); // sees the same variates as the recorded run
+ * @endcode
+ *
+ * @note Only available on POSIX systems.
+ *
+ * @tparam Engine the engine that produced the recording, with a static
+ * getName()
+ */
+template<class Engine>
+class ReplayEngine
+{
+public:
+	typedef typename Engine::result_type result_type;
+
+	ReplayEngine() :
+			seed_(0), map(0), maplen(0), data(0), size_(0), pos(0), laps_(0)
+	{
+	}
+	/**
+	 * Map the recording @p filename.
+	 *
+	 * A previously opened recording is closed first.
+	 * @return false if the file cannot be mapped, has not been recorded on
+	 * a compatible platform or has been recorded from another engine
+	 */
+	bool open(const char* filename)
+	{
+		close();
+		int fd = ::open(filename, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (::fstat(fd, &st) != 0
+				|| static_cast<std::size_t>(st.st_size) <= sizeof(RecordHeader))
+		{
+			::close(fd);
+			return false;
+		}
+		void* p = ::mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (p == MAP_FAILED)
+			return false;
+		const RecordHeader* h = static_cast<const RecordHeader*>(p);
+		std::size_t n = (st.st_size - sizeof(RecordHeader))
+				/ sizeof(result_type);
+		if (!h->compatible(sizeof(result_type), Engine::getName()) || n == 0)
+		{
+			::munmap(p, st.st_size);
+			return false;
+		}
+		::madvise(p, st.st_size, MADV_SEQUENTIAL);
+		map = p;
+		maplen = st.st_size;
+		data = reinterpret_cast<const result_type*>(h + 1);
+		size_ = n;
+		pos = 0;
+		laps_ = 0;
+		return true;
+	}
+	/**
+	 * Unmap the recording.
+	 */
+	void close()
+	{
+		if (map)
+			::munmap(map, maplen);
+		map = 0;
+		maplen = 0;
+		data = 0;
+		size_ = pos = 0;
+	}
+	/**
+	 * Restart the replay from the beginning.
+	 *
+	 * The recorded stream does not depend on the seed; @p s is only stored.
+	 */
+	void seed(unsigned long int s)
+	{
+		seed_ = s;
+		pos = 0;
+		laps_ = 0;
+	}
+	/**
+	 * Get the seed passed to seed()
+	 */
+	unsigned long int getSeed() const
+	{
+		return seed_;
+	}
+	/**
+	 * Get the name of the random number generator engine
+	 */
+	static const char* getName()
+	{
+		return "Replay";
+	}
+	/**
+	 * Get the number of values in the recording
+	 */
+	std::size_t size() const
+	{
+		return size_;
+	}
+	/**
+	 * Get the index of the next value to be replayed
+	 */
+	std::size_t position() const
+	{
+		return pos;
+	}
+	/**
+	 * Continue the replay at value @p i
+	 */
+	void seek(std::size_t i)
+	{
+		assert(i < size_);
+		pos = i;
+	}
+	/**
+	 * Get the number of times the replay has started over
+	 */
+	unsigned long int laps() const
+	{
+		return laps_;
+	}
+	/**
+	 * Get the number of regenerations of the state.
+	 *
+	 * Always 0, a replay has no state to regenerate; see laps().
+	 */
+	unsigned long long getRefills() const
+	{
+		return 0;
+	}
+	/**
+	 * Smallest raw random number
+	 */
+	static constexpr result_type min()
+	{
+		return Engine::min();
+	}
+	/**
+	 * Largest raw random number
+	 */
+	static constexpr result_type max()
+	{
+		return Engine::max();
+	}
+	/// Produce the next recorded raw number.
+	result_type operator()()
+	{
+		assert(data);
+		if (pos == size_)
+		{
+			pos = 0;
+			++laps_;
+		}
+		return data[pos++];
+	}
+	/**
+	 * Convert a raw random number to a double as @p Engine does
+	 */
+	static double canonical(result_type y)
+	{
+		return Engine::canonical(y);
+	}
+
+protected:
+	~ReplayEngine()
+	{
+		close();
+	}
+
+private:
+	ReplayEngine(const ReplayEngine&);
+	ReplayEngine& operator=(const ReplayEngine&);
+
+	unsigned long int seed_; ///< the seed passed to seed()
+	void* map; ///< start of the mapping
+	std::size_t maplen; ///< length of the mapping
+	const result_type* data; ///< recorded values
+	std::size_t size_; ///< number of recorded values
+	std::size_t pos; ///< index of the next value
+	unsigned long int laps_; ///< number of times the replay started over
+};
+
+} /* namespace myrng */
+#endif /* REPLAYENGINE_H_ */
@@ -0,0 +1,394 @@
+/**
+ * Scrambled Sobol quasi-random sequence
+ *
+ * @file SobolEngine.h
+ */
+
+#ifndef SOBOLENGINE_H_
+#define SOBOLENGINE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <ctime>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+#include "serialize.h"
+#include "sobolTable.h"
+#include "util.h"
+
+namespace myrng
+{
+
+/**
+ * Generator of the Sobol low-discrepancy sequence in @c dimension()
+ * dimensions.
+ *
+ * Unlike the pseudo-random engines, each call of next() returns a whole
+ * point of the sequence, one raw number per coordinate. The first 2^m
+ * points put exactly one point into each of the 2^m intervals
+ * [k 2^-m, (k+1) 2^-m) in every coordinate, and the two-dimensional
+ * projections are well distributed as well, so Monte Carlo integrals over
+ * the unit cube converge faster than with independent random numbers. The
+ * direction numbers are those of Joe and Kuo for up to maxDimension()
+ * dimensions, see sobolTable.h.
+ *
+ * Points are generated in Gray-code order: point n+1 differs from point n by
+ * the XOR of a single direction number per coordinate, so next() costs
+ * O(d). seek() jumps to any index in O(32 d). At most 2^32 points can be
+ * generated.
+ *
+ * The seed selects a random scrambling that keeps the net properties of the
+ * sequence, so that independent seeds give independent unbiased estimates
+ * whose spread yields an error bar:
+ * - OWEN: nested uniform scrambling, computed with the hash of B. Burley,
+ *   "Practical Hash-based Owen Scrambling", JCGT 9(4), 2020. Costs a few
+ *   multiplications per coordinate.
+ * - LINEAR: random linear matrix scrambling of the direction numbers with a
+ *   digital shift (J. Matousek, "On the L2-discrepancy for anchored boxes",
+ *   J. Complexity 14, 1998). Applied once per seed, so next() is as fast as
+ *   for the plain sequence.
+ * - NONE: the plain sequence, which starts with the origin.
+ *
+ * Use it through QuasiVariates:
+ * @code
+ * myrng::Sobol qrng(3);
+ * double x[3];
+ * qrng.Seed(42);
+ * for (int i = 0; i < 1024; ++i)
+ * {
+ *     qrng.Uniform01(x);
+ *     sum += f(x);
+ * }
+ * @endcode
+ */
+class SobolEngine
+{
+public:
+	/// Type of the raw random numbers
+	typedef uint32_t result_type;
+
+	/// Kind of scrambling, see SobolEngine
+	enum Scrambling
+	{
+		NONE, LINEAR, OWEN
+	};
+
+	/**
+	 * Constructor
+	 * @param d dimension, at most maxDimension()
+	 * @param mode kind of scrambling
+	 */
+	explicit SobolEngine(std::size_t d = 1, Scrambling mode = OWEN) :
+			d_(d), mode_(mode), n_(0), V(32 * d), x(d), keys(d), point(d)
+	{
+		assert(d >= 1 && d <= maxDimension());
+		initDirections();
+		seed((unsigned long) std::time(0));
+	}
+	/**
+	 * Set the seed of the scrambling and restart at the first point
+	 */
+	void seed(unsigned long int s)
+	{
+		seed_ = s;
+		scramble();
+		seek(0);
+	}
+	/**
+	 * Get random number generator seed
+	 */
+	unsigned long int getSeed() const
+	{
+		return seed_;
+	}
+	/**
+	 * Get the name of the random number generator engine
+	 */
+	static const char* getName()
+	{
+		return "Sobol";
+	}
+	/**
+	 * Choose the kind of scrambling, keeping seed and position
+	 */
+	void setScrambling(Scrambling mode)
+	{
+		mode_ = mode;
+		scramble();
+		seek(n_);
+	}
+	/**
+	 * Get the kind of scrambling
+	 */
+	Scrambling getScrambling() const
+	{
+		return mode_;
+	}
+	/**
+	 * Get the number of coordinates of a point
+	 */
+	std::size_t dimension() const
+	{
+		return d_;
+	}
+	/**
+	 * Largest dimension supported by the table of direction numbers
+	 */
+	static constexpr std::size_t maxDimension()
+	{
+		return sobol::DIMENSIONS;
+	}
+	/**
+	 * Smallest raw random number
+	 */
+	static constexpr result_type min()
+	{
+		return 0;
+	}
+	/**
+	 * Largest raw random number
+	 */
+	static constexpr result_type max()
+	{
+		return 0xffffffffU;
+	}
+	/**
+	 * Get the index of the point returned by the next call of next()
+	 */
+	uint64_t index() const
+	{
+		return n_;
+	}
+	/**
+	 * Produce the next point.
+	 * @return pointer to @c dimension() raw numbers, valid until the next
+	 * call
+	 */
+	const result_type* next()
+	{
+		assert(n_ < LENGTH);
+		if (mode_ == OWEN)
+			for (std::size_t j = 0; j < d_; ++j)
+				point[j] = owen(x[j], keys[j]);
+		else
+			for (std::size_t j = 0; j < d_; ++j)
+				point[j] = x[j];
+		// the Gray codes of n and n + 1 differ in the lowest zero bit of n
+		unsigned int c = 0;
+		while ((n_ >> c) & 1)
+			++c;
+		if (c < 32)
+		{
+			const uint32_t* Vc = &V[c * d_];
+			for (std::size_t j = 0; j < d_; ++j)
+				x[j] ^= Vc[j];
+		}
+		++n_;
+		return &point[0];
+	}
+	/**
+	 * Continue with the point of index @p n, at most 2^32.
+	 */
+	void seek(uint64_t n)
+	{
+		assert(n <= LENGTH);
+		const uint64_t gray = n ^ (n >> 1);
+		for (std::size_t j = 0; j < d_; ++j)
+			x[j] = shift(j);
+		for (unsigned int c = 0; c < 32; ++c)
+			if ((gray >> c) & 1)
+			{
+				const uint32_t* Vc = &V[c * d_];
+				for (std::size_t j = 0; j < d_; ++j)
+					x[j] ^= Vc[j];
+			}
+		n_ = n;
+	}
+	/**
+	 * Skip @p z points
+	 */
+	void discard(unsigned long long z)
+	{
+		seek(n_ + z);
+	}
+	/**
+	 * Convert a raw random number to a double on the interval (0,1).
+	 *
+	 * Maps to the centre of the interval of width 2^-32, so that even the
+	 * origin of the plain sequence can be transformed by an inverse
+	 * distribution function.
+	 */
+	static double canonical(result_type y)
+	{
+		return (y + 0.5) * (1.0 / 4294967296.0);
+	}
+	/**
+	 * Write the complete generator state to @p os.
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		serialize::writeTag(os, getName());
+		serialize::write32(os, d_);
+		serialize::writeUInt(os, mode_, 1);
+		serialize::write64(os, seed_);
+		serialize::write64(os, n_);
+		return os;
+	}
+	/**
+	 * Restore a generator state written by save().
+	 *
+	 * The dimension has to be the same. On error the failbit of @p is is
+	 * set and the state is left unchanged.
+	 */
+	std::istream& load(std::istream& is)
+	{
+		std::size_t d;
+		uint64_t mode, n;
+		unsigned long int s;
+		if (!serialize::readTag(is, getName()) || !serialize::read32(is, d)
+				|| d != d_ || !serialize::readUInt(is, mode, 1) || mode > OWEN
+				|| !serialize::read64(is, s) || !serialize::read64(is, n)
+				|| n > LENGTH)
+			return serialize::fail(is);
+		seed_ = s;
+		mode_ = static_cast<Scrambling>(mode);
+		scramble();
+		seek(n);
+		return is;
+	}
+
+protected:
+	~SobolEngine()
+	{
+	}
+
+private:
+	/// Number of points of the sequence
+	static const uint64_t LENGTH = uint64_t(1) << 32;
+
+	/// Direction numbers of the plain sequence
+	void initDirections()
+	{
+		plainV.resize(32 * d_);
+		for (unsigned int k = 0; k < 32; ++k)
+			plainV[k * d_] = uint32_t(1) << (31 - k);
+		const uint16_t* t = sobol::TABLE;
+		for (std::size_t j = 1; j < d_; ++j)
+		{
+			// degree s and inner coefficients a of the polynomial
+			const unsigned int p = *t++;
+			unsigned int s = 0;
+			while (p >> (s + 1))
+				++s;
+			const unsigned int a = (p >> 1) & ((1U << (s - 1)) - 1);
+			uint32_t v[32];
+			for (unsigned int k = 0; k < s; ++k)
+				v[k] = uint32_t(*t++) << (31 - k);
+			// recurrence of Bratley and Fox, ACM TOMS 14, 1988
+			for (unsigned int k = s; k < 32; ++k)
+			{
+				v[k] = v[k - s] ^ (v[k - s] >> s);
+				for (unsigned int i = 1; i < s; ++i)
+					if ((a >> (s - 1 - i)) & 1)
+						v[k] ^= v[k - i];
+			}
+			for (unsigned int k = 0; k < 32; ++k)
+				plainV[k * d_ + j] = v[k];
+		}
+	}
+	/// Key of coordinate @p j for the current seed
+	uint64_t key(std::size_t j) const
+	{
+		return util::splitmix64(util::splitmix64(seed_) + j);
+	}
+	/// Start value of coordinate @p j, i.e. the digital shift
+	uint32_t shift(std::size_t j) const
+	{
+		if (mode_ != LINEAR)
+			return 0;
+		return static_cast<uint32_t>(util::splitmix64(key(j) + 32));
+	}
+	/// Derive the scrambled direction numbers and keys from the seed
+	void scramble()
+	{
+		for (std::size_t j = 0; j < d_; ++j)
+			keys[j] = static_cast<uint32_t>(key(j));
+		if (mode_ != LINEAR)
+		{
+			V = plainV;
+			return;
+		}
+		for (std::size_t j = 0; j < d_; ++j)
+		{
+			// lower triangular matrix with unit diagonal: output bit 31 - r
+			// depends on input bit 31 - r and random more significant bits
+			uint32_t L[32];
+			for (unsigned int r = 0; r < 32; ++r)
+			{
+				const uint32_t diagonal = uint32_t(1) << (31 - r);
+				const uint32_t above = ~(diagonal | (diagonal - 1));
+				L[r] = diagonal
+						| (static_cast<uint32_t>(util::splitmix64(key(j) + r))
+								& above);
+			}
+			for (unsigned int k = 0; k < 32; ++k)
+			{
+				const uint32_t v = plainV[k * d_ + j];
+				uint32_t w = 0;
+				for (unsigned int r = 0; r < 32; ++r)
+					w |= parity(L[r] & v) << (31 - r);
+				V[k * d_ + j] = w;
+			}
+		}
+	}
+	static uint32_t parity(uint32_t v)
+	{
+		v ^= v >> 16;
+		v ^= v >> 8;
+		v ^= v >> 4;
+		v ^= v >> 2;
+		v ^= v >> 1;
+		return v & 1;
+	}
+	static uint32_t reverse(uint32_t v)
+	{
+		v = (v >> 16) | (v << 16);
+		v = ((v >> 8) & 0x00ff00ffU) | ((v & 0x00ff00ffU) << 8);
+		v = ((v >> 4) & 0x0f0f0f0fU) | ((v & 0x0f0f0f0fU) << 4);
+		v = ((v >> 2) & 0x33333333U) | ((v & 0x33333333U) << 2);
+		v = ((v >> 1) & 0x55555555U) | ((v & 0x55555555U) << 1);
+		return v;
+	}
+	/**
+	 * Nested uniform scrambling of @p v with key @p k.
+	 *
+	 * In bit-reversed order, each step flips bits depending on the lower bits
+	 * only, i.e. every digit is permuted depending on the more significant
+	 * digits, as Owen's scrambling requires.
+	 */
+	static uint32_t owen(uint32_t v, uint32_t k)
+	{
+		v = reverse(v);
+		v += k;
+		v ^= v * 0x6c50b47cU;
+		v ^= v * 0xb82f1e52U;
+		v ^= v * 0xc7afe638U;
+		v ^= v * 0x8d22f6e6U;
+		return reverse(v);
+	}
+
+	std::size_t d_; ///< dimension
+	Scrambling mode_;
+	unsigned long int seed_; ///< seed of the scrambling
+	uint64_t n_; ///< index of the next point
+	std::vector<uint32_t> plainV; ///< direction number k of coordinate j at k d + j
+	std::vector<uint32_t> V; ///< scrambled direction numbers, same layout
+	std::vector<uint32_t> x; ///< coordinates of point n_ before Owen scrambling
+	std::vector<uint32_t> keys; ///< keys of the Owen scrambling
+	std::vector<uint32_t> point; ///< the point returned by next()
+};
+
+} /* namespace myrng */
+#endif /* SOBOLENGINE_H_ */
@@ -0,0 +1,315 @@
+/**
+ * Compact independent random number streams for many agents
+ *
+ * @file StreamArena.h
+ */
+
+#ifndef STREAMARENA_H_
+#define STREAMARENA_H_
+
+#include <cassert>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+#include "RandomVariates.h"
+#include "XoshiroEngine.h"
+#include "serialize.h"
+
+namespace myrng
+{
+
+/**
+ * Engine working on the state of one stream stored in a StreamArena.
+ *
+ * The engine only refers to the four state words; drawing numbers advances
+ * them in place. Views are obtained from StreamArena::operator[]().
+ */
+class StreamEngine
+{
+public:
+	/// Type of the raw random numbers
+	typedef Xoshiro128Engine::result_type result_type;
+
+	/**
+	 * Constructor of an unbound engine, see bind()
+	 */
+	StreamEngine() :
+			s_(0), base_(0), id_(0)
+	{
+	}
+	/**
+	 * Refer to the state @p s of stream @p id of seed @p base
+	 */
+	void bind(uint32_t* s, uint64_t base, uint64_t id)
+	{
+		s_ = s;
+		base_ = base;
+		id_ = id;
+	}
+	/**
+	 * Restart the stream with the state of stream id() of seed @p s
+	 */
+	void seed(unsigned long int s)
+	{
+		assert(s_);
+		base_ = s;
+		Xoshiro128Engine::seedState(s_, s, id_);
+	}
+	/**
+	 * Get the seed of the stream
+	 */
+	unsigned long int getSeed() const
+	{
+		return static_cast<unsigned long int>(base_);
+	}
+	/**
+	 * Get the number of the stream in its arena
+	 */
+	uint64_t id() const
+	{
+		return id_;
+	}
+	/**
+	 * Get the name of the random number generator engine
+	 */
+	static const char* getName()
+	{
+		return Xoshiro128Engine::getName();
+	}
+	/**
+	 * Smallest raw random number
+	 */
+	static constexpr result_type min()
+	{
+		return Xoshiro128Engine::min();
+	}
+	/**
+	 * Largest raw random number
+	 */
+	static constexpr result_type max()
+	{
+		return Xoshiro128Engine::max();
+	}
+	/**
+	 * Produce a raw random number.
+	 */
+	result_type operator()()
+	{
+		return Xoshiro128Engine::step(s_);
+	}
+	/**
+	 * Convert a raw random number to a double on the open interval (0,1).
+	 */
+	static double canonical(result_type y)
+	{
+		return Xoshiro128Engine::canonical(y);
+	}
+	/**
+	 * Advance the state by @p z steps, one step at a time.
+	 */
+	void discard(unsigned long long z)
+	{
+		while (z--)
+			Xoshiro128Engine::step(s_);
+	}
+	/**
+	 * Get the number of regenerations of the state, always 0.
+	 */
+	unsigned long long getRefills() const
+	{
+		return 0;
+	}
+	/**
+	 * Write the state of the stream to @p os.
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		serialize::writeTag(os, getName());
+		for (unsigned int i = 0; i < Xoshiro128Engine::WORDS; ++i)
+			serialize::write32(os, s_[i]);
+		return os;
+	}
+	/**
+	 * Restore a state written by save() into the stream.
+	 *
+	 * On error the failbit of @p is is set and the state is left unchanged.
+	 */
+	std::istream& load(std::istream& is)
+	{
+		uint32_t t[Xoshiro128Engine::WORDS];
+		if (!serialize::readTag(is, getName())
+				|| !Xoshiro128Engine::readState(is, t))
+			return serialize::fail(is);
+		for (unsigned int i = 0; i < Xoshiro128Engine::WORDS; ++i)
+			s_[i] = t[i];
+		return is;
+	}
+
+protected:
+	~StreamEngine()
+	{
+	}
+
+private:
+	uint32_t* s_; ///< state of the stream in the arena
+	uint64_t base_; ///< seed of the stream
+	uint64_t id_; ///< number of the stream
+};
+
+/**
+ * Random variates from one stream of a StreamArena.
+ */
+typedef RandomVariates<StreamEngine> StreamRNG;
+
+/**
+ * Independent random number streams for millions of agents.
+ *
+ * Every agent owns a xoshiro128** generator (see Xoshiro128Engine) of 16
+ * bytes, instead of the 2.5 kB of an MT19937, and the states of all agents
+ * are stored contiguously in one array. Stream @p id starts from a state
+ * derived from the seed of the arena and @p id in constant time, so the
+ * numbers an agent draws depend only on the seed, its id and its own
+ * history. Changing the order in which the agents are updated, or
+ * distributing them over threads or processes, does not change the
+ * results, unlike drawing from one shared generator.
+ *
+ * operator[]() returns a StreamRNG, i.e. RandomVariates working directly on
+ * the state of the agent in the arena. The view is cheap to create and is
+ * meant to be discarded after the update of the agent. Variates that
+ * RandomVariates caches between calls, i.e. the second normal variate of
+ * the polar method and the unused bits of RandomBit(), are discarded with
+ * the view; they are still reproducible, as they only depend on the calls
+ * made on the views of this agent. Example:
+ * @code
+ * myrng::StreamArena streams(10000000, seed); // 160 MB for 10^7 agents
+ * #pragma omp parallel for
+ * for (std::size_t i = 0; i < agents.size(); ++i)
+ * {
+ *     myrng::StreamRNG rng = streams[i];
+ *     if (rng.Chance(agents[i].risk))
+ *         agents[i].infect(rng.Exponential(recovery));
+ * }
+ * @endcode
+ * Views of different agents can be used by different threads at the same
+ * time, as they share no state.
+ */
+class StreamArena
+{
+public:
+	/**
+	 * Constructor
+	 * @param n number of streams
+	 * @param s seed of the arena
+	 */
+	explicit StreamArena(std::size_t n = 0, unsigned long int s = 0) :
+			base_(s), state_(n * Xoshiro128Engine::WORDS)
+	{
+		for (std::size_t id = 0; id < n; ++id)
+			reset(id);
+	}
+	/**
+	 * Restart all streams from the seed @p s
+	 */
+	void seed(unsigned long int s)
+	{
+		base_ = s;
+		for (std::size_t id = 0; id < size(); ++id)
+			reset(id);
+	}
+	/**
+	 * Get the seed of the arena
+	 */
+	unsigned long int getSeed() const
+	{
+		return static_cast<unsigned long int>(base_);
+	}
+	/**
+	 * Get the number of streams
+	 */
+	std::size_t size() const
+	{
+		return state_.size() / Xoshiro128Engine::WORDS;
+	}
+	/**
+	 * Change the number of streams to @p n.
+	 *
+	 * Streams that are kept continue where they are, new streams start
+	 * from their initial state, so an agent with id @p k draws the same
+	 * numbers whenever it is added.
+	 */
+	void resize(std::size_t n)
+	{
+		const std::size_t old = size();
+		state_.resize(n * Xoshiro128Engine::WORDS);
+		for (std::size_t id = old; id < n; ++id)
+			reset(id);
+	}
+	/**
+	 * Restart stream @p id from its initial state
+	 */
+	void reset(std::size_t id)
+	{
+		assert(id < size());
+		Xoshiro128Engine::seedState(&state_[id * Xoshiro128Engine::WORDS],
+				base_, id);
+	}
+	/**
+	 * Get random variates from stream @p id.
+	 *
+	 * The view stays valid until the arena is resized or destroyed.
+	 */
+	StreamRNG operator[](std::size_t id)
+	{
+		assert(id < size());
+		StreamRNG view;
+		view.bind(&state_[id * Xoshiro128Engine::WORDS], base_, id);
+		return view;
+	}
+	/**
+	 * Write the seed and the states of all streams to @p os.
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		serialize::writeTag(os, "StreamArena");
+		serialize::write64(os, base_);
+		serialize::write64(os, size());
+		for (std::size_t i = 0; i < state_.size(); ++i)
+			serialize::write32(os, state_[i]);
+		return os;
+	}
+	/**
+	 * Restore an arena written by save(), including its size.
+	 *
+	 * On error the failbit of @p is is set and the arena is left unchanged.
+	 */
+	std::istream& load(std::istream& is)
+	{
+		uint64_t s, n;
+		if (!serialize::readTag(is, "StreamArena") || !serialize::read64(is, s)
+				|| !serialize::read64(is, n)
+				|| n > state_.max_size() / Xoshiro128Engine::WORDS)
+			return serialize::fail(is);
+		// grow while reading, so that a corrupt count fails at the end of
+		// the data instead of allocating its size up front
+		std::vector<uint32_t> state;
+		uint32_t t[Xoshiro128Engine::WORDS];
+		for (uint64_t id = 0; id < n; ++id)
+		{
+			if (!Xoshiro128Engine::readState(is, t))
+				return serialize::fail(is);
+			state.insert(state.end(), t, t + Xoshiro128Engine::WORDS);
+		}
+		base_ = s;
+		state_.swap(state);
+		return is;
+	}
+
+private:
+	uint64_t base_; ///< seed of the arena
+	std::vector<uint32_t> state_; ///< state of stream id at 4 id
+};
+
+} /* namespace myrng */
+#endif /* STREAMARENA_H_ */
@@ -1,23 +1,36 @@
 #ifndef WELLENGINE_H_
 #define WELLENGINE_H_
 
-#include <cassert>
+#include <cstddef>
 #include <ctime>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+#include "jump.h"
+#include "serialize.h"
 
 namespace myrng
 {
 
 /**
- * The WELL1024a random number generator.
+ * The WELL family of random number generators.
  *
- * The acronym WELL stands for "Well Equidistributed Long-period Linear". It
- * has a period of 2^1024, which should be enough for most simulation
- * tasks. It has better equidistribution properties and it recovers faster
- * from a "bad state", e.g. bad initialization, than the MT19937.
+ * The acronym WELL stands for "Well Equidistributed Long-period Linear". The
+ * generators have a period of 2^k-1, where k = 32 R - P is the number of
+ * bits of the state. They have better equidistribution properties and they
+ * recover faster from a "bad state", e.g. bad initialization, than the
+ * MT19937.
  * For more information see F. Panneton, P. L'Ecuyer, and M. Matsumoto,
  * "Improved Long-Period Generators Based on Linear Recurrences Modulo 2",
  * ACM Transactions on Mathematical Software, 32, 1 (2006), 1-16.
  *
+ * The recurrence is fixed at compile time by @p Params, which provides the
+ * state size @c R, the number @c P of unused bits, the taps @c M1, @c M2,
+ * @c M3 and the transformations @c T0 to @c T7 of the paper, as well as the
+ * name of the generator. See WELL512aParams, WELL1024aParams,
+ * WELL19937aParams and WELL44497aParams.
+ *
  * @author Gerd Zschaler <gzschaler@googlemail.com>
  * @author Marton Morvai
  * @author Thilo Gross <gross@physics.org>
@@ -28,13 +41,15 @@ namespace myrng
  * or send a letter to Creative Commons, 444 Castro Street, Suite 900, Mountain
  * View, California, 94041, USA.
  */
-class WELLEngine
+template<class Params>
+class BasicWELLEngine
 {
 public:
-	WELLEngine()
+	/// Type of the raw random numbers
+	typedef uint32_t result_type;
+
+	BasicWELLEngine()
 	{
-		// Long has to be at least 32 bits!
-		assert(sizeof(long) >= 4);
 		state_i = 0;
 		seed((unsigned long) std::time(0));
 	}
@@ -44,19 +59,15 @@ public:
 	void seed(unsigned long int s)
 	{
 		/*
-		 * After the engine has been seeded, this function generates 50.000
+		 * After the engine has been seeded, this function generates 10.000
 		 * random numbers to let it recover at least a little bit from a
 		 * bad initial state.
 		 */
 		seed_ = s;
+		state_i = 0;
 		STATE[0] = s & 0xffffffffUL;
-		for (int i = 1; i < 32; ++i)
-		{
-			STATE[i] =
-					(1812433253UL * (STATE[i - 1] ^ (STATE[i - 1] >> 30)) + i);
-			STATE[i] &= 0xffffffffUL;
-			// for >32 bit machines
-		}
+		for (unsigned int i = 1; i < R; ++i)
+			STATE[i] = 1812433253U * (STATE[i - 1] ^ (STATE[i - 1] >> 30)) + i;
 		for (int j = 0; j < 10000; ++j)
 			(*this)();
 	}
@@ -70,45 +81,357 @@ public:
 	/**
 	 * Get the name of the random number generator engine
 	 */
-	const char* getName()
+	static const char* getName()
 	{
-		return "WELL1024a";
+		return Params::name();
 	}
-
-protected:
-	~WELLEngine()
+	/**
+	 * Smallest raw random number
+	 */
+	static constexpr result_type min()
+	{
+		return 0;
+	}
+	/**
+	 * Largest raw random number
+	 */
+	static constexpr result_type max()
 	{
+		return 0xffffffffU;
 	}
-	/// Produce a random number.
-	double operator()()
+	/**
+	 * Produce a raw random number.
+	 *
+	 * All 32 bits are uniformly distributed, so the engine can be used
+	 * directly with the distributions and algorithms of \<random\> and
+	 * \<algorithm\>, e.g. std::shuffle.
+	 */
+	result_type operator()()
 	{
 		/*
-		 * This generator is an Implementation of WELL1024a
+		 * Generic form of the WELL recurrence, see Algorithm 1 of
 		 * (F. Panneton, P. L'Ecuyer, and M. Matsumoto,
 		 * "Improved Long-Period Generators Based on Linear Recurrences Modulo 2",
 		 * ACM Transactions on Mathematical Software, 32, 1 (2006), 1-16.)
 		 */
-		z0 = STATE[(state_i + 31) & 0x0000001fU];
-		z1 = (STATE[state_i]) ^ STATE[(state_i + 3) & 0x0000001fU];
-		z2 = (STATE[(state_i + 24) & 0x0000001fU]
-				^ (STATE[(state_i + 24) & 0x0000001fU] << (19)))
-				^ (STATE[(state_i + 10) & 0x0000001fU]
-						^ (STATE[(state_i + 10) & 0x0000001fU] << (14)));
+		uint32_t z0, z1, z2, z3;
+		const uint32_t VRm1 = STATE[mod(state_i + R - 1)];
+		if (P == 0)
+			z0 = VRm1;
+		else
+			z0 = (VRm1 & MASKL) | (STATE[mod(state_i + R - 2)] & MASKU);
+		z1 = Params::T0(STATE[state_i]) ^ Params::T1(STATE[mod(state_i + M1)]);
+		z2 = Params::T2(STATE[mod(state_i + M2)])
+				^ Params::T3(STATE[mod(state_i + M3)]);
+		z3 = z1 ^ z2;
 
-		STATE[state_i] = z1 ^ z2;
-		STATE[(state_i + 31) & 0x0000001fU] = (z0 ^ (z0 << (11)))
-				^ (z1 ^ (z1 << (7))) ^ (z2 ^ (z2 << (13)));
+		STATE[state_i] = z3;
+		state_i = mod(state_i + R - 1);
+		STATE[state_i] = Params::T4(z0) ^ Params::T5(z1) ^ Params::T6(z2)
+				^ Params::T7(z3);
+		return STATE[state_i];
+	}
+	/**
+	 * Write @p n raw numbers to @p out.
+	 *
+	 * Equivalent to @p n calls of operator()(); the recurrence produces one
+	 * word at a time, so there is nothing to gain from a block.
+	 */
+	void fill(result_type* out, std::size_t n)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+			out[i] = (*this)();
+	}
+	/**
+	 * Convert a raw random number to a double on the interval [0,1).
+	 */
+	static double canonical(result_type y)
+	{
+		return ((double) y * 2.32830643653869628906e-10);
+	}
+	/**
+	 * Advance the state by @p z steps.
+	 *
+	 * Equivalent to @p z calls of operator()(), but for large @p z the
+	 * state is jumped ahead with the minimal polynomial of the recurrence,
+	 * see jump.h, which takes at most a fraction of a second for any @p z.
+	 * The first jump computes the polynomial once for all engines of this
+	 * type.
+	 */
+	void discard(unsigned long long z)
+	{
+		if (z < 32ULL * R)
+		{
+			while (z--)
+				(*this)();
+			return;
+		}
+		const jump::Polynomial c = jump::powerMod(z, minimalPolynomial());
+		std::vector<uint32_t> acc(R, 0);
+		for (int i = 0; i <= c.degree(); ++i)
+		{
+			if (c.coefficient(i))
+				for (unsigned int l = 0; l < R; ++l)
+					acc[l] ^= STATE[mod(state_i + l)];
+			(*this)();
+		}
+		for (unsigned int l = 0; l < R; ++l)
+			STATE[l] = acc[l];
+		state_i = 0;
+	}
+	/**
+	 * Get the number of regenerations of the state.
+	 *
+	 * Always 0, the WELL generators update one word per call.
+	 */
+	unsigned long long getRefills() const
+	{
+		return 0;
+	}
+	/**
+	 * Write the complete generator state to @p os.
+	 *
+	 * The state is written in a compact, platform independent binary format
+	 * and can be restored with load().
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		serialize::writeTag(os, getName());
+		serialize::write64(os, seed_);
+		serialize::write32(os, state_i);
+		for (unsigned int i = 0; i < R; ++i)
+			serialize::write32(os, STATE[i]);
+		return os;
+	}
+	/**
+	 * Restore a generator state written by save().
+	 *
+	 * On error the failbit of @p is is set and the state is left unchanged.
+	 */
+	std::istream& load(std::istream& is)
+	{
+		unsigned long int s;
+		unsigned int i;
+		uint32_t state[R];
+		if (!serialize::readTag(is, getName()) || !serialize::read64(is, s)
+				|| !serialize::read32(is, i) || i >= R)
+			return serialize::fail(is);
+		for (unsigned int k = 0; k < R; ++k)
+			if (!serialize::read32(is, state[k]))
+				return serialize::fail(is);
+		seed_ = s;
+		state_i = i;
+		for (unsigned int k = 0; k < R; ++k)
+			STATE[k] = state[k];
+		return is;
+	}
 
-		state_i = (state_i + 31) & 0x0000001fUL;
-		return ((double) STATE[state_i] * 2.32830643653869628906e-10);
+protected:
+	~BasicWELLEngine()
+	{
 	}
 
 private:
+	static const unsigned int R = Params::R; ///< number of state words
+	static const unsigned int P = Params::P; ///< number of unused bits
+	static const unsigned int M1 = Params::M1;
+	static const unsigned int M2 = Params::M2;
+	static const unsigned int M3 = Params::M3;
+	static const uint32_t MASKU = P ? 0xffffffffU >> (32 - P) : 0U;
+	static const uint32_t MASKL = ~MASKU;
+
+	/// Reduce an index in [0, 2R) modulo R
+	static unsigned int mod(unsigned int i)
+	{
+		if ((R & (R - 1)) == 0)
+			return i & (R - 1);
+		return i < R ? i : i - R;
+	}
+
+	/// Minimal polynomial of the recurrence, computed on first use
+	static const jump::Polynomial& minimalPolynomial()
+	{
+		static const jump::Polynomial p = computeMinimalPolynomial();
+		return p;
+	}
+	/// Run Berlekamp-Massey on the lowest bit of 64 R numbers
+	static jump::Polynomial computeMinimalPolynomial()
+	{
+		BasicWELLEngine e;
+		e.seed(5489);
+		std::vector<bool> s(64 * R);
+		for (std::size_t i = 0; i < s.size(); ++i)
+			s[i] = e() & 1;
+		return jump::berlekampMassey(s);
+	}
+
 	unsigned long int seed_; ///< the initial seed
 
-	unsigned int z0, z1, z2, state_i;
-	unsigned int STATE[32];
+	unsigned int state_i;
+	uint32_t STATE[R];
+};
+
+/**
+ * The transformations T0 to T7 of the WELL generators, named after the
+ * macros of the reference implementation by Panneton et al.
+ */
+namespace well
+{
+/// The zero matrix, MAT7(v)
+inline uint32_t zero(uint32_t)
+{
+	return 0;
+}
+/// The identity, MAT1(v)
+inline uint32_t identity(uint32_t v)
+{
+	return v;
+}
+/// MAT0POS(t,v)
+template<int t>
+inline uint32_t mat0pos(uint32_t v)
+{
+	return v ^ (v >> t);
+}
+/// MAT0NEG(-t,v)
+template<int t>
+inline uint32_t mat0neg(uint32_t v)
+{
+	return v ^ (v << t);
+}
+/// MAT3POS(t,v)
+template<int t>
+inline uint32_t mat3pos(uint32_t v)
+{
+	return v >> t;
+}
+/// MAT3NEG(-t,v)
+template<int t>
+inline uint32_t mat3neg(uint32_t v)
+{
+	return v << t;
+}
+/// MAT4NEG(-t,b,v)
+template<int t, uint32_t b>
+inline uint32_t mat4neg(uint32_t v)
+{
+	return v ^ ((v << t) & b);
+}
+/// MAT5(r,a,ds,dt,v)
+template<int r, uint32_t a, uint32_t ds, uint32_t dt>
+inline uint32_t mat5(uint32_t v)
+{
+	uint32_t x = ((v << r) ^ (v >> (32 - r))) & ds;
+	return (v & dt) ? x ^ a : x;
+}
+}
+
+/**
+ * Parameters of WELL512a (period 2^512-1).
+ */
+struct WELL512aParams
+{
+	enum
+	{
+		R = 16, P = 0, M1 = 13, M2 = 9, M3 = 5
+	};
+	static const char* name()
+	{
+		return "WELL512a";
+	}
+	static uint32_t T0(uint32_t v) { return well::mat0neg<16>(v); }
+	static uint32_t T1(uint32_t v) { return well::mat0neg<15>(v); }
+	static uint32_t T2(uint32_t v) { return well::mat0pos<11>(v); }
+	static uint32_t T3(uint32_t v) { return well::zero(v); }
+	static uint32_t T4(uint32_t v) { return well::mat0neg<2>(v); }
+	static uint32_t T5(uint32_t v) { return well::mat0neg<18>(v); }
+	static uint32_t T6(uint32_t v) { return well::mat3neg<28>(v); }
+	static uint32_t T7(uint32_t v) { return well::mat4neg<5, 0xda442d24U>(v); }
 };
 
+/**
+ * Parameters of WELL1024a (period 2^1024-1).
+ */
+struct WELL1024aParams
+{
+	enum
+	{
+		R = 32, P = 0, M1 = 3, M2 = 24, M3 = 10
+	};
+	static const char* name()
+	{
+		return "WELL1024a";
+	}
+	static uint32_t T0(uint32_t v) { return well::identity(v); }
+	static uint32_t T1(uint32_t v) { return well::mat0pos<8>(v); }
+	static uint32_t T2(uint32_t v) { return well::mat0neg<19>(v); }
+	static uint32_t T3(uint32_t v) { return well::mat0neg<14>(v); }
+	static uint32_t T4(uint32_t v) { return well::mat0neg<11>(v); }
+	static uint32_t T5(uint32_t v) { return well::mat0neg<7>(v); }
+	static uint32_t T6(uint32_t v) { return well::mat0neg<13>(v); }
+	static uint32_t T7(uint32_t v) { return well::zero(v); }
+};
+
+/**
+ * Parameters of WELL19937a (period 2^19937-1).
+ */
+struct WELL19937aParams
+{
+	enum
+	{
+		R = 624, P = 31, M1 = 70, M2 = 179, M3 = 449
+	};
+	static const char* name()
+	{
+		return "WELL19937a";
+	}
+	static uint32_t T0(uint32_t v) { return well::mat0neg<25>(v); }
+	static uint32_t T1(uint32_t v) { return well::mat0pos<27>(v); }
+	static uint32_t T2(uint32_t v) { return well::mat3pos<9>(v); }
+	static uint32_t T3(uint32_t v) { return well::mat0pos<1>(v); }
+	static uint32_t T4(uint32_t v) { return well::identity(v); }
+	static uint32_t T5(uint32_t v) { return well::mat0neg<9>(v); }
+	static uint32_t T6(uint32_t v) { return well::mat0neg<21>(v); }
+	static uint32_t T7(uint32_t v) { return well::mat0pos<21>(v); }
+};
+
+/**
+ * Parameters of WELL44497a (period 2^44497-1).
+ */
+struct WELL44497aParams
+{
+	enum
+	{
+		R = 1391, P = 15, M1 = 23, M2 = 481, M3 = 229
+	};
+	static const char* name()
+	{
+		return "WELL44497a";
+	}
+	static uint32_t T0(uint32_t v) { return well::mat0neg<24>(v); }
+	static uint32_t T1(uint32_t v) { return well::mat0pos<30>(v); }
+	static uint32_t T2(uint32_t v) { return well::mat0neg<10>(v); }
+	static uint32_t T3(uint32_t v) { return well::mat3neg<26>(v); }
+	static uint32_t T4(uint32_t v) { return well::identity(v); }
+	static uint32_t T5(uint32_t v) { return well::mat0pos<20>(v); }
+	static uint32_t T6(uint32_t v)
+	{
+		return well::mat5<9, 0xb729fcecU, 0xfbffffffU, 0x00020000U>(v);
+	}
+	static uint32_t T7(uint32_t v) { return well::identity(v); }
+};
+
+/// The WELL512a random number generator.
+typedef BasicWELLEngine<WELL512aParams> WELL512Engine;
+
+/// The WELL1024a random number generator.
+typedef BasicWELLEngine<WELL1024aParams> WELLEngine;
+
+/// The WELL19937a random number generator.
+typedef BasicWELLEngine<WELL19937aParams> WELL19937Engine;
+
+/// The WELL44497a random number generator.
+typedef BasicWELLEngine<WELL44497aParams> WELL44497Engine;
+
 } /* namespace myrng */
 #endif /* WELLENGINE_H_ */
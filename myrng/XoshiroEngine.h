@@ -0,0 +1,208 @@
+/**
+ * Compact xoshiro128** random number generator
+ *
+ * @file XoshiroEngine.h
+ */
+
+#ifndef XOSHIROENGINE_H_
+#define XOSHIROENGINE_H_
+
+#include <ctime>
+#include <istream>
+#include <ostream>
+#include <stdint.h>
+#include "RandomVariates.h"
+#include "serialize.h"
+#include "util.h"
+
+namespace myrng
+{
+
+/**
+ * The xoshiro128** generator of D. Blackman and S. Vigna, "Scrambled linear
+ * pseudorandom number generators", ACM TOMS 47, 36 (2021).
+ *
+ * Its state is only four 32-bit words, with a period of 2^128 - 1, and a
+ * step takes a handful of shifts, rotations and XORs. This makes it the
+ * engine of choice where very many independent generators have to be kept,
+ * see StreamArena; for a single generator the WELL and Mersenne Twister
+ * engines have far longer periods.
+ *
+ * The state is derived from the seed and a stream number with splitmix64
+ * by seedState(), in constant time. Streams with different numbers are
+ * statistically independent for all practical purposes.
+ */
+class Xoshiro128Engine
+{
+public:
+	/// Type of the raw random numbers
+	typedef uint32_t result_type;
+	/// Number of 32-bit words of the state
+	static const unsigned int WORDS = 4;
+
+	Xoshiro128Engine()
+	{
+		seed((unsigned long) std::time(0));
+	}
+	/**
+	 * Set random number generator seed
+	 */
+	void seed(unsigned long int s)
+	{
+		seed_ = s;
+		seedState(state, s, 0);
+	}
+	/**
+	 * Get random number generator seed
+	 */
+	unsigned long int getSeed() const
+	{
+		return seed_;
+	}
+	/**
+	 * Get the name of the random number generator engine
+	 */
+	static const char* getName()
+	{
+		return "xoshiro128**";
+	}
+	/**
+	 * Smallest raw random number
+	 */
+	static constexpr result_type min()
+	{
+		return 0;
+	}
+	/**
+	 * Largest raw random number
+	 */
+	static constexpr result_type max()
+	{
+		return 0xffffffffU;
+	}
+	/**
+	 * Produce a raw random number.
+	 */
+	result_type operator()()
+	{
+		return step(state);
+	}
+	/**
+	 * Convert a raw random number to a double on the open interval (0,1).
+	 */
+	static double canonical(result_type y)
+	{
+		return (y + 0.5) * (1.0 / 4294967296.0);
+	}
+	/**
+	 * Advance the state by @p z steps, one step at a time.
+	 */
+	void discard(unsigned long long z)
+	{
+		while (z--)
+			step(state);
+	}
+	/**
+	 * Get the number of regenerations of the state.
+	 *
+	 * Always 0, the generator updates its state in every call.
+	 */
+	unsigned long long getRefills() const
+	{
+		return 0;
+	}
+	/**
+	 * Write the complete generator state to @p os.
+	 */
+	std::ostream& save(std::ostream& os) const
+	{
+		serialize::writeTag(os, getName());
+		serialize::write64(os, seed_);
+		for (unsigned int i = 0; i < WORDS; ++i)
+			serialize::write32(os, state[i]);
+		return os;
+	}
+	/**
+	 * Restore a generator state written by save().
+	 *
+	 * On error the failbit of @p is is set and the state is left unchanged.
+	 */
+	std::istream& load(std::istream& is)
+	{
+		unsigned long int s;
+		uint32_t t[WORDS];
+		if (!serialize::readTag(is, getName()) || !serialize::read64(is, s)
+				|| !readState(is, t))
+			return serialize::fail(is);
+		seed_ = s;
+		for (unsigned int i = 0; i < WORDS; ++i)
+			state[i] = t[i];
+		return is;
+	}
+
+	/**
+	 * Advance the state @p s by one step and return the next raw number.
+	 */
+	static result_type step(uint32_t* s)
+	{
+		const uint32_t result = rotl(s[1] * 5, 7) * 9;
+		const uint32_t t = s[1] << 9;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 11);
+		return result;
+	}
+	/**
+	 * Set @p s to the initial state of stream @p id of seed @p base.
+	 *
+	 * The 128 bits are two consecutive splitmix64 outputs started from a
+	 * hash of @p base and @p id, which differs for all ids of a seed.
+	 */
+	static void seedState(uint32_t* s, uint64_t base, uint64_t id)
+	{
+		const uint64_t a = util::splitmix64(util::splitmix64(base) + id);
+		const uint64_t b = util::splitmix64(a);
+		s[0] = static_cast<uint32_t>(a);
+		s[1] = static_cast<uint32_t>(a >> 32);
+		s[2] = static_cast<uint32_t>(b);
+		s[3] = static_cast<uint32_t>(b >> 32);
+		if ((a | b) == 0) // the only state without a successor
+			s[0] = 1;
+	}
+	/**
+	 * Read a state written word by word with serialize::write32().
+	 * @return false if the state is incomplete or zero
+	 */
+	static bool readState(std::istream& is, uint32_t* s)
+	{
+		for (unsigned int i = 0; i < WORDS; ++i)
+			if (!serialize::read32(is, s[i]))
+				return false;
+		return (s[0] | s[1] | s[2] | s[3]) != 0;
+	}
+
+protected:
+	~Xoshiro128Engine()
+	{
+	}
+
+private:
+	static uint32_t rotl(uint32_t x, int k)
+	{
+		return (x << k) | (x >> (32 - k));
+	}
+
+	unsigned long int seed_; ///< seed
+	uint32_t state[WORDS]; ///< state vector
+};
+
+/**
+ * Random variates using the xoshiro128** engine.
+ */
+typedef RandomVariates<Xoshiro128Engine> Xoshiro128;
+
+} /* namespace myrng */
+#endif /* XOSHIROENGINE_H_ */
@@ -0,0 +1,227 @@
+/**
+ * Jump-ahead helpers for F2-linear generators
+ *
+ * @file jump.h
+ */
+
+#ifndef MYRNG_JUMP_H_
+#define MYRNG_JUMP_H_
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace myrng
+{
+/**
+ * Jump-ahead for generators whose state evolves by a linear map A over
+ * GF(2), such as the WELL and Mersenne Twister engines.
+ *
+ * If P is the minimal polynomial of A and x^z mod P = sum c_i x^i, the state
+ * z steps ahead is sum c_i A^i s, i.e. the XOR of the states after those
+ * steps i < deg P with c_i = 1. The engines obtain P once with
+ * berlekampMassey() from one bit of their output, reduce x^z with
+ * powerMod() and then accumulate the states while stepping through deg P
+ * steps. A jump thus costs O(k^2 log z) bit operations plus k steps of the
+ * generator for a state of k bits, independent of the size of z.
+ */
+namespace jump
+{
+/**
+ * Polynomial over GF(2).
+ *
+ * Bit i % 64 of word i / 64 is the coefficient of x^i.
+ */
+class Polynomial
+{
+public:
+	/// The zero polynomial
+	Polynomial() :
+			deg(-1)
+	{
+	}
+	/// Degree, -1 for the zero polynomial
+	int degree() const
+	{
+		return deg;
+	}
+	/// Coefficient of x^i
+	bool coefficient(int i) const
+	{
+		return i <= deg && ((words[i >> 6] >> (i & 63)) & 1);
+	}
+	/// Coefficients of x^(64 i) to x^(64 i + 63)
+	uint64_t word(std::size_t i) const
+	{
+		return i < words.size() ? words[i] : 0;
+	}
+	/// Flip the coefficient of x^i
+	void flip(int i)
+	{
+		if (static_cast<std::size_t>(i >> 6) >= words.size())
+			words.resize((i >> 6) + 1, 0);
+		words[i >> 6] ^= uint64_t(1) << (i & 63);
+		normalize();
+	}
+	/// Add @p p multiplied by x^@p shift
+	void addShifted(const Polynomial& p, int shift)
+	{
+		xorShifted(p, shift);
+		normalize();
+	}
+	/// Square, which over GF(2) spreads the coefficients to even powers
+	Polynomial squared() const
+	{
+		Polynomial q;
+		if (deg < 0)
+			return q;
+		q.words.assign(2 * words.size(), 0);
+		for (std::size_t i = 0; i < words.size(); ++i)
+		{
+			q.words[2 * i] = spread(static_cast<uint32_t>(words[i]));
+			q.words[2 * i + 1] = spread(static_cast<uint32_t>(words[i] >> 32));
+		}
+		q.normalize();
+		return q;
+	}
+	/// Reduce modulo @p p
+	void reduce(const Polynomial& p)
+	{
+		if (deg < p.deg)
+			return;
+		for (int i = deg; i >= p.deg; --i)
+			if ((words[i >> 6] >> (i & 63)) & 1)
+				xorShifted(p, i - p.deg);
+		normalize();
+	}
+
+private:
+	std::vector<uint64_t> words;
+	int deg;
+
+	/// addShifted() without updating the degree
+	void xorShifted(const Polynomial& p, int shift)
+	{
+		if (p.deg < 0)
+			return;
+		const std::size_t size = ((p.deg + shift) >> 6) + 1;
+		if (words.size() < size)
+			words.resize(size, 0);
+		const int w = shift >> 6, b = shift & 63;
+		for (std::size_t i = 0; i < p.words.size(); ++i)
+		{
+			words[i + w] ^= p.words[i] << b;
+			if (b && i + w + 1 < size)
+				words[i + w + 1] ^= p.words[i] >> (64 - b);
+		}
+	}
+	/// Drop leading zero words and recompute the degree
+	void normalize()
+	{
+		int i = static_cast<int>(words.size()) - 1;
+		while (i >= 0 && words[i] == 0)
+			--i;
+		words.resize(i + 1);
+		deg = -1;
+		if (i >= 0)
+			for (deg = 64 * i + 63; !((words[i] >> (deg & 63)) & 1); --deg)
+				;
+	}
+	static uint64_t spread(uint32_t v)
+	{
+		uint64_t x = v;
+		x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+		x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+		x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+		x = (x | (x << 2)) & 0x3333333333333333ULL;
+		x = (x | (x << 1)) & 0x5555555555555555ULL;
+		return x;
+	}
+};
+
+/**
+ * Minimal polynomial of a binary sequence.
+ *
+ * The Berlekamp-Massey algorithm finds the shortest linear recurrence
+ * sum_i c_i s_{n-i} = 0 satisfied by @p s, returned as the polynomial
+ * sum_i c_i x^(L-i) with c_0 = 1 of degree L. If the sequence is generated
+ * by a linear map whose minimal polynomial has degree k, 2k bits suffice.
+ * @param s the bits of the sequence
+ */
+inline Polynomial berlekampMassey(const std::vector<bool>& s)
+{
+	const int n = static_cast<int>(s.size());
+	// Connection polynomials C and B with c_i the coefficient of x^i
+	Polynomial C, B;
+	C.flip(0);
+	B.flip(0);
+	int L = 0, m = 1;
+	// the sequence reversed, packed into words, so that the discrepancy
+	// is the parity of C AND a window of it
+	std::vector<uint64_t> r((n >> 6) + 2, 0);
+	for (int i = 0; i < n; ++i)
+		if (s[n - 1 - i])
+			r[i >> 6] |= uint64_t(1) << (i & 63);
+	for (int k = 0; k < n; ++k)
+	{
+		// d = sum_{i=0}^{L} c_i s_{k-i}, where s_{k-i} is bit n-1-k+i of r
+		uint64_t d = 0;
+		const int offset = n - 1 - k;
+		for (int i = 0; i <= L; i += 64)
+		{
+			const int j = offset + i, w = j >> 6, b = j & 63;
+			uint64_t window = r[w] >> b;
+			if (b)
+				window |= r[w + 1] << (64 - b);
+			d ^= C.word(i >> 6) & window; // the degree of C is at most L
+		}
+		for (int shift = 32; shift; shift >>= 1)
+			d ^= d >> shift;
+		if ((d & 1) == 0)
+			++m;
+		else if (2 * L <= k)
+		{
+			const Polynomial T = C;
+			C.addShifted(B, m);
+			L = k + 1 - L;
+			B = T;
+			m = 1;
+		}
+		else
+		{
+			C.addShifted(B, m);
+			++m;
+		}
+	}
+	// reverse C to obtain the characteristic polynomial of degree L
+	Polynomial P;
+	for (int i = 0; i <= L; ++i)
+		if (C.coefficient(i))
+			P.flip(L - i);
+	return P;
+}
+
+/**
+ * Compute x^@p z modulo @p p.
+ */
+inline Polynomial powerMod(unsigned long long z, const Polynomial& p)
+{
+	Polynomial r;
+	r.flip(0);
+	for (int bit = 63; bit >= 0; --bit)
+	{
+		r = r.squared();
+		if ((z >> bit) & 1)
+		{
+			Polynomial x;
+			x.addShifted(r, 1);
+			r = x;
+		}
+		r.reduce(p);
+	}
+	return r;
+}
+
+} /* namespace jump */
+} /* namespace myrng */
+#endif /* MYRNG_JUMP_H_ */
@@ -53,6 +53,11 @@
  * double y = rng_mt.Exponential(0.7);
  * @endcode
  *
+ * Both engines are members of families of generators whose parameters are
+ * fixed at compile time, see myrng::BasicWELLEngine and myrng::BasicMTEngine.
+ * The variants WELL512a, WELL19937a, WELL44497a, MT11213 and MT19937_64 are
+ * available with the same interface, e.g. to trade state size for period.
+ *
  * For further information see the full source code documentation.
  *
  * @par Disclaimer:
@@ -80,6 +85,31 @@ namespace myrng
 	 * Random variates using the MT19937 engine.
 	 */
 	typedef RandomVariates<MTEngine> MT19937;
+
+	/**
+	 * Random variates using the WELL512a engine.
+	 */
+	typedef RandomVariates<WELL512Engine> WELL512a;
+
+	/**
+	 * Random variates using the WELL19937a engine.
+	 */
+	typedef RandomVariates<WELL19937Engine> WELL19937a;
+
+	/**
+	 * Random variates using the WELL44497a engine.
+	 */
+	typedef RandomVariates<WELL44497Engine> WELL44497a;
+
+	/**
+	 * Random variates using the MT11213B engine.
+	 */
+	typedef RandomVariates<MT11213Engine> MT11213;
+
+	/**
+	 * Random variates using the 64-bit MT19937-64 engine.
+	 */
+	typedef RandomVariates<MT19937_64Engine> MT19937_64;
 }
 
 #endif /* MYRNG_H_ */
@@ -0,0 +1,150 @@
+/**
+ * Binary serialization helpers
+ *
+ * @file serialize.h
+ */
+
+#ifndef MYRNG_SERIALIZE_H_
+#define MYRNG_SERIALIZE_H_
+
+#include <istream>
+#include <ostream>
+#include <cstring>
+#include <string>
+#include <stdint.h>
+
+namespace myrng
+{
+/**
+ * Portable binary encoding of generator states.
+ *
+ * All integers are written in little-endian byte order with a fixed width,
+ * so that saved states can be restored on any platform.
+ */
+namespace serialize
+{
+/// Write the lower @p bytes bytes of @p v
+inline void writeUInt(std::ostream& os, uint64_t v, int bytes)
+{
+	char buf[8];
+	for (int i = 0; i < bytes; ++i)
+		buf[i] = static_cast<char>((v >> (8 * i)) & 0xff);
+	os.write(buf, bytes);
+}
+
+/// Read an unsigned integer of @p bytes bytes
+inline bool readUInt(std::istream& is, uint64_t& v, int bytes)
+{
+	unsigned char buf[8];
+	if (!is.read(reinterpret_cast<char*>(buf), bytes))
+		return false;
+	v = 0;
+	for (int i = 0; i < bytes; ++i)
+		v |= static_cast<uint64_t>(buf[i]) << (8 * i);
+	return true;
+}
+
+/// Write a 32 bit word
+inline void write32(std::ostream& os, uint32_t v)
+{
+	writeUInt(os, v, 4);
+}
+
+/// Read a 32 bit word
+template<class T>
+inline bool read32(std::istream& is, T& v)
+{
+	uint64_t x;
+	if (!readUInt(is, x, 4))
+		return false;
+	v = static_cast<T>(x);
+	return true;
+}
+
+/// Write a 64 bit word
+inline void write64(std::ostream& os, uint64_t v)
+{
+	writeUInt(os, v, 8);
+}
+
+/// Read a 64 bit word
+template<class T>
+inline bool read64(std::istream& is, T& v)
+{
+	uint64_t x;
+	if (!readUInt(is, x, 8))
+		return false;
+	v = static_cast<T>(x);
+	return true;
+}
+
+/// Write the bit pattern of an IEEE double
+inline void writeDouble(std::ostream& os, double d)
+{
+	uint64_t v;
+	std::memcpy(&v, &d, sizeof v);
+	write64(os, v);
+}
+
+/// Read a double written by writeDouble()
+inline bool readDouble(std::istream& is, double& d)
+{
+	uint64_t v;
+	if (!read64(is, v))
+		return false;
+	std::memcpy(&d, &v, sizeof d);
+	return true;
+}
+
+/**
+ * Write a name tag identifying the type of the following data.
+ */
+inline void writeTag(std::ostream& os, const char* tag)
+{
+	std::size_t len = std::strlen(tag);
+	writeUInt(os, len, 1);
+	os.write(tag, len);
+}
+
+/**
+ * Read a name tag and compare it with @p tag.
+ * @return false on read error or if the tags differ
+ */
+inline bool readTag(std::istream& is, const char* tag)
+{
+	uint64_t len;
+	if (!readUInt(is, len, 1) || len != std::strlen(tag))
+		return false;
+	char buf[256];
+	if (!is.read(buf, len))
+		return false;
+	return std::memcmp(buf, tag, len) == 0;
+}
+
+/**
+ * Read a name tag of any content into @p tag.
+ * @return false on read error
+ */
+inline bool readTag(std::istream& is, std::string& tag)
+{
+	uint64_t len;
+	char buf[256];
+	if (!readUInt(is, len, 1) || !is.read(buf, len))
+		return false;
+	tag.assign(buf, len);
+	return true;
+}
+
+/**
+ * Mark a failed load on @p is.
+ * @return @p is
+ */
+inline std::istream& fail(std::istream& is)
+{
+	is.setstate(std::ios::failbit);
+	return is;
+}
+}
+}
+
+#endif /* MYRNG_SERIALIZE_H_ */
@@ -0,0 +1,152 @@
+/**
+ * Instrumentation counters
+ *
+ * @file stats.h
+ */
+
+#ifndef MYRNG_STATS_H_
+#define MYRNG_STATS_H_
+
+#include <ostream>
+#include <iomanip>
+
+/**
+ * Increment an instrumentation counter.
+ *
+ * The counters are only maintained if the program is compiled with
+ * -DMYRNG_STATS. Otherwise the macro expands to nothing, so that the
+ * instrumentation has no cost at all.
+ */
+#ifdef MYRNG_STATS
+#define MYRNG_COUNT(counter) (++(counter))
+#else
+#define MYRNG_COUNT(counter) ((void) 0)
+#endif
+
+namespace myrng
+{
+
+/**
+ * Counters describing how random numbers have been consumed.
+ *
+ * Obtained from RandomVariates::stats(). All counters are zero unless the
+ * program is compiled with -DMYRNG_STATS.
+ * Example:
+ * @code
+ * myrng::MT19937 rng;
+ * simulate(rng);
+ * std::cerr << rng.stats(); // e.g. check how often Gamma() rejects
+ * @endcode
+ */
+struct Stats
+{
+	typedef unsigned long long count_t;
+
+	/// Distributions whose calls are counted
+	enum Distribution
+	{
+		UNIFORM01,
+		FROMTO,
+		DICE,
+		INTFROMTO,
+		CHANCE,
+		CHOICES,
+		NORMAL01POLAR,
+		GAUSSIANPOLAR,
+		EXPONENTIAL,
+		GAMMA,
+		BETA,
+		UNIFORM01F,
+		NORMAL01F,
+		EXPONENTIALF,
+		RANDOMBIT,
+		RANDOMBITS,
+		ZIPF,
+		ZETA,
+		UNITVECTOR,
+		INBALL,
+		UNIFORM01_53,
+		TRUNCATEDNORMAL,
+		BINOMIAL,
+		MULTINOMIAL,
+		DIRICHLET,
+		DISTRIBUTIONS ///< number of distributions
+	};
+
+	count_t words; ///< raw words drawn from the engine
+	count_t refills; ///< complete regenerations of the engine state
+	count_t polarTries; ///< pairs tried by Normal01Polar() and Normal01f()
+	count_t gammaTries; ///< candidates tried by Gamma()
+	count_t zipfTries; ///< candidates tried by Zipf() and Zeta()
+	count_t truncatedTries; ///< candidates tried by TruncatedNormal()
+	count_t binomialTries; ///< candidates tried by Binomial() with rejection
+	/// calls per distribution, including calls made by other distributions
+	count_t calls[DISTRIBUTIONS];
+
+	Stats()
+	{
+		reset();
+	}
+	/// Set all counters to zero
+	void reset()
+	{
+		words = refills = polarTries = gammaTries = zipfTries = truncatedTries
+				= binomialTries = 0;
+		for (int i = 0; i < DISTRIBUTIONS; ++i)
+			calls[i] = 0;
+	}
+	/// Name of distribution @p d
+	static const char* name(int d)
+	{
+		static const char* names[DISTRIBUTIONS] =
+		{ "Uniform01", "FromTo", "Dice", "IntFromTo", "Chance", "Choices",
+				"Normal01Polar", "GaussianPolar", "Exponential", "Gamma",
+				"Beta", "Uniform01f", "Normal01f", "Exponentialf",
+				"RandomBit", "RandomBits", "Zipf", "Zeta", "UnitVector",
+				"InBall", "Uniform01_53", "TruncatedNormal", "Binomial",
+				"Multinomial", "Dirichlet" };
+		return names[d];
+	}
+};
+
+/**
+ * Print a report of the counters, one per line.
+ *
+ * Rejection counters are followed by the mean number of tries per variate;
+ * distributions that have not been called are omitted.
+ */
+inline std::ostream& operator<<(std::ostream& os, const Stats& s)
+{
+	os << "raw words          " << s.words << "\n";
+	os << "state refills      " << s.refills << "\n";
+	os << "polar tries        " << s.polarTries;
+	const Stats::count_t normals = s.calls[Stats::NORMAL01POLAR]
+			+ s.calls[Stats::NORMAL01F];
+	if (normals)
+		os << "  (" << double(s.polarTries) / normals << " per call)";
+	os << "\ngamma tries        " << s.gammaTries;
+	if (s.calls[Stats::GAMMA])
+		os << "  (" << double(s.gammaTries) / s.calls[Stats::GAMMA]
+				<< " per call)";
+	os << "\nzipf tries         " << s.zipfTries;
+	const Stats::count_t zipfs = s.calls[Stats::ZIPF] + s.calls[Stats::ZETA];
+	if (zipfs)
+		os << "  (" << double(s.zipfTries) / zipfs << " per call)";
+	os << "\ntruncated tries    " << s.truncatedTries;
+	if (s.calls[Stats::TRUNCATEDNORMAL])
+		os << "  (" << double(s.truncatedTries) / s.calls[Stats::TRUNCATEDNORMAL]
+				<< " per call)";
+	os << "\nbinomial tries     " << s.binomialTries;
+	if (s.calls[Stats::BINOMIAL])
+		os << "  (" << double(s.binomialTries) / s.calls[Stats::BINOMIAL]
+				<< " per call)";
+	os << "\n";
+	for (int i = 0; i < Stats::DISTRIBUTIONS; ++i)
+		if (s.calls[i])
+			os << std::left << std::setw(19) << Stats::name(i) << std::right
+					<< s.calls[i] << "\n";
+	return os;
+}
+
+} /* namespace myrng */
+#endif /* MYRNG_STATS_H_ */
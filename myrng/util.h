@@ -8,7 +8,10 @@
 #define MYRNG_UTIL_H_
 
 #include <iterator>
+#include <utility>
 #include <cassert>
+#include <cmath>
+#include <stdint.h>
 
 namespace myrng
 {
@@ -60,6 +63,250 @@ inline _Iter random_from(std::pair<_Iter, _Iter> range, RandomGen& rnd)
 {
 	return random_from(range.first, range.second, rnd);
 }
+
+/**
+ * Draw a sorted random sample of @p n distinct integers from [0,N).
+ *
+ * All subsets of size @p n are equally likely. The integers are written to
+ * @p out in increasing order. Uses Algorithm D of J. S. Vitter, "An
+ * efficient algorithm for sequential random sampling", ACM TOMS 13, 1
+ * (1987), 58-67, which generates the gaps between the selected integers
+ * directly: it takes O(n) time and constant memory, independent of @p N,
+ * and needs no hash set to reject duplicates. @p N has to be smaller than
+ * 2^53.
+ * @param n sample size, at most @p N
+ * @param N size of the population
+ * @param out output iterator receiving the integers as @p T
+ * @param rnd random variates generator
+ * @return @p out after the last integer
+ */
+template<class T, class OutputIterator, class RandomGen>
+OutputIterator sorted_sample(T n, T N, OutputIterator out, RandomGen& rnd)
+{
+	assert(n <= N);
+	if (n == 0)
+		return out;
+	const double negalphainv = -13.; // use Algorithm A if n > N/13
+	double nreal = n, Nreal = N, ninv = 1. / nreal;
+	double qu1real = Nreal - nreal + 1.;
+	T qu1 = N - n + 1;
+	double threshold = -negalphainv * nreal;
+	double Vprime = std::exp(std::log(rnd.Uniform01()) * ninv);
+	T current = 0; // index of the next candidate
+	T S;
+	while (n > 1 && threshold < Nreal)
+	{
+		const double nmin1inv = 1. / (nreal - 1.);
+		for (;;)
+		{
+			double X;
+			for (;;) // D2: generate the skip S from the continuous approximation
+			{
+				X = Nreal * (1. - Vprime);
+				S = static_cast<T>(X);
+				if (S < qu1)
+					break;
+				Vprime = std::exp(std::log(rnd.Uniform01()) * ninv);
+			}
+			const double U = rnd.Uniform01();
+			const double negSreal = -static_cast<double>(S);
+			const double y1 = std::exp(std::log(U * Nreal / qu1real) * nmin1inv);
+			Vprime = y1 * (1. - X / Nreal) * (qu1real / (negSreal + qu1real));
+			if (Vprime <= 1.) // D3: accept by the squeeze
+				break;
+			// D4: accept or reject with the exact probabilities
+			double y2 = 1., top = Nreal - 1., bottom;
+			T limit;
+			if (n - 1 > S)
+			{
+				bottom = Nreal - nreal;
+				limit = N - S;
+			}
+			else
+			{
+				bottom = Nreal + negSreal - 1.;
+				limit = qu1;
+			}
+			for (T t = N - 1; t >= limit; --t)
+			{
+				y2 = (y2 * top) / bottom;
+				top -= 1.;
+				bottom -= 1.;
+			}
+			if (Nreal / (Nreal - X) >= y1 * std::exp(std::log(y2) * nmin1inv))
+			{
+				Vprime = std::exp(std::log(rnd.Uniform01()) * nmin1inv);
+				break;
+			}
+			Vprime = std::exp(std::log(rnd.Uniform01()) * ninv);
+		}
+		// D5: skip S integers and select the next one
+		current += S;
+		*out++ = current++;
+		N -= S + 1;
+		Nreal = N;
+		--n;
+		nreal = n;
+		ninv = nmin1inv;
+		qu1 -= S;
+		qu1real -= S;
+		threshold += negalphainv;
+	}
+	if (n > 1)
+	{
+		// Algorithm A for the remaining n > N/13 integers
+		double top = Nreal - nreal;
+		while (n >= 2)
+		{
+			const double V = rnd.Uniform01();
+			S = 0;
+			double quot = top / Nreal;
+			while (quot > V)
+			{
+				++S;
+				top -= 1.;
+				Nreal -= 1.;
+				quot = (quot * top) / Nreal;
+			}
+			current += S;
+			*out++ = current++;
+			Nreal -= 1.;
+			--n;
+		}
+		S = static_cast<T>(Nreal * rnd.Uniform01());
+	}
+	else
+		S = static_cast<T>(Nreal * Vprime);
+	// the last integer is uniform on the remaining ones
+	*out++ = current + S;
+	return out;
+}
+
+/**
+ * Generate the edges of an Erdős–Rényi random graph G(n,p).
+ *
+ * Every pair of the nodes 0,...,n-1 is connected with probability @p p,
+ * independently of the others. Instead of drawing a Bernoulli variate for
+ * each of the n(n-1)/2 pairs, the number of pairs skipped before the next
+ * edge is drawn from the geometric distribution, see V. Batagelj and
+ * U. Brandes, "Efficient generation of large random networks", Phys. Rev.
+ * E 71, 036113 (2005). The running time is O(n + m) for m edges.
+ * Example:
+ * @code
+ * std::vector<std::pair<unsigned, unsigned> > edges;
+ * myrng::util::erdos_renyi_gnp(10000000u, 1e-6, std::back_inserter(edges), rng);
+ * @endcode
+ * @param n number of nodes
+ * @param p probability of an edge
+ * @param out output iterator receiving the edges as std::pair<T,T>(v,w)
+ * with w < v, in lexicographic order
+ * @param rnd random variates generator
+ * @return @p out after the last edge
+ */
+template<class T, class OutputIterator, class RandomGen>
+OutputIterator erdos_renyi_gnp(T n, double p, OutputIterator out,
+		RandomGen& rnd)
+{
+	if (n < 2 || p <= 0.)
+		return out;
+	if (p >= 1.)
+	{
+		for (T v = 1; v < n; ++v)
+			for (T w = 0; w < v; ++w)
+				*out++ = std::make_pair(v, w);
+		return out;
+	}
+	const double logq = std::log1p(-p);
+	T v = 1;
+	double w = -1.; // may be -1, and beyond the range of T while skipping
+	for (;;)
+	{
+		w += 1. + std::floor(std::log1p(-rnd.Uniform01()) / logq);
+		while (w >= v && v < n)
+		{
+			w -= v;
+			++v;
+		}
+		if (v >= n)
+			return out;
+		*out++ = std::make_pair(v, static_cast<T>(w));
+	}
+}
+
+/**
+ * Generate the edges of an Erdős–Rényi random graph G(n,m).
+ *
+ * Selects exactly @p m of the n(n-1)/2 pairs of the nodes 0,...,n-1,
+ * with all such graphs equally likely. The edges are drawn as a sorted
+ * sample of pair indices with sorted_sample() and decoded incrementally,
+ * so the running time is O(n + m) and no hash set of edges is needed.
+ * @param n number of nodes, n(n-1)/2 has to be smaller than 2^53
+ * @param m number of edges, at most n(n-1)/2
+ * @param out output iterator receiving the edges as std::pair<T,T>(v,w)
+ * with w < v, in lexicographic order
+ * @param rnd random variates generator
+ * @return @p out after the last edge
+ */
+template<class T, class OutputIterator, class RandomGen>
+OutputIterator erdos_renyi_gnm(T n, T m, OutputIterator out, RandomGen& rnd)
+{
+	if (n < 2)
+	{
+		assert(m == 0);
+		return out;
+	}
+	struct Decoder
+	{
+		OutputIterator out;
+		T v; ///< node of the current row of the triangle
+		uint64_t base; ///< index of the pair (v,0)
+
+		/// Write the edge with index @p e; indices have to increase
+		Decoder& operator=(uint64_t e)
+		{
+			while (e - base >= static_cast<uint64_t>(v))
+			{
+				base += v;
+				++v;
+			}
+			*out++ = std::make_pair(v, static_cast<T>(e - base));
+			return *this;
+		}
+		Decoder& operator*()
+		{
+			return *this;
+		}
+		Decoder& operator++()
+		{
+			return *this;
+		}
+		Decoder& operator++(int)
+		{
+			return *this;
+		}
+	};
+	const uint64_t pairs = static_cast<uint64_t>(n) * (n - 1) / 2;
+	Decoder decoder =
+	{ out, 1, 0 };
+	decoder = sorted_sample<uint64_t>(m, pairs, decoder, rnd);
+	return decoder.out;
+}
+
+/**
+ * The splitmix64 mixing function.
+ *
+ * A bijective hash of 64-bit integers with good avalanche behaviour, see
+ * G. L. Steele, D. Lea, and C. H. Flood, "Fast Splittable Pseudorandom
+ * Number Generators", OOPSLA 2014. Used to derive well separated seeds for
+ * independent streams from a single seed.
+ */
+inline uint64_t splitmix64(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
 }
 }
 
@@ -0,0 +1,852 @@
+/**
+ * @file QualityTests.h
+ * @date 19.10.2026
+ *
+ * Statistical quality battery reporting p-values.
+ */
+
+#ifndef QUALITYTESTS_H_
+#define QUALITYTESTS_H_
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <cfloat>
+#include <chrono>
+
+namespace quality
+{
+
+typedef unsigned long long count_t;
+
+const double PI = 3.14159265358979323846;
+
+/**
+ * Regularized upper incomplete gamma function Q(a,x) by continued fraction.
+ * Only accurate for x >= a + 1.
+ */
+inline double gammaQcf(double a, double x)
+{
+	const double tiny = DBL_MIN / DBL_EPSILON;
+	double b = x + 1. - a;
+	double c = 1. / tiny;
+	double d = 1. / b;
+	double h = d;
+	for (int i = 1; i < 100000; ++i)
+	{
+		double an = -i * (i - a);
+		b += 2.;
+		d = an * d + b;
+		if (std::fabs(d) < tiny)
+			d = tiny;
+		c = b + an / c;
+		if (std::fabs(c) < tiny)
+			c = tiny;
+		d = 1. / d;
+		double del = d * c;
+		h *= del;
+		if (std::fabs(del - 1.) < DBL_EPSILON)
+			break;
+	}
+	return std::exp(-x + a * std::log(x) - std::lgamma(a)) * h;
+}
+
+/**
+ * Regularized lower incomplete gamma function P(a,x) by series expansion.
+ * Only accurate for x < a + 1.
+ */
+inline double gammaPser(double a, double x)
+{
+	double ap = a;
+	double del = 1. / a;
+	double sum = del;
+	int itmax = 1000 + static_cast<int>(20. * std::sqrt(a));
+	for (int i = 0; i < itmax; ++i)
+	{
+		ap += 1.;
+		del *= x / ap;
+		sum += del;
+		if (std::fabs(del) < std::fabs(sum) * DBL_EPSILON)
+			break;
+	}
+	return sum * std::exp(-x + a * std::log(x) - std::lgamma(a));
+}
+
+/// Regularized lower incomplete gamma function P(a,x).
+inline double gammaP(double a, double x)
+{
+	if (x <= 0.)
+		return 0.;
+	return (x < a + 1.) ? gammaPser(a, x) : 1. - gammaQcf(a, x);
+}
+
+/// Regularized upper incomplete gamma function Q(a,x) = 1 - P(a,x).
+inline double gammaQ(double a, double x)
+{
+	if (x <= 0.)
+		return 1.;
+	return (x < a + 1.) ? 1. - gammaPser(a, x) : gammaQcf(a, x);
+}
+
+/// Continued fraction for the incomplete beta function.
+inline double betacf(double a, double b, double x)
+{
+	const double tiny = DBL_MIN / DBL_EPSILON;
+	double qab = a + b, qap = a + 1., qam = a - 1.;
+	double c = 1., d = 1. - qab * x / qap;
+	if (std::fabs(d) < tiny)
+		d = tiny;
+	d = 1. / d;
+	double h = d;
+	for (int m = 1; m < 10000; ++m)
+	{
+		int m2 = 2 * m;
+		double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+		d = 1. + aa * d;
+		if (std::fabs(d) < tiny)
+			d = tiny;
+		c = 1. + aa / c;
+		if (std::fabs(c) < tiny)
+			c = tiny;
+		d = 1. / d;
+		h *= d * c;
+		aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+		d = 1. + aa * d;
+		if (std::fabs(d) < tiny)
+			d = tiny;
+		c = 1. + aa / c;
+		if (std::fabs(c) < tiny)
+			c = tiny;
+		d = 1. / d;
+		double del = d * c;
+		h *= del;
+		if (std::fabs(del - 1.) < DBL_EPSILON)
+			break;
+	}
+	return h;
+}
+
+/// Regularized incomplete beta function I_x(a,b).
+inline double betaI(double a, double b, double x)
+{
+	if (x <= 0.)
+		return 0.;
+	if (x >= 1.)
+		return 1.;
+	double bt = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b)
+			+ a * std::log(x) + b * std::log(1. - x));
+	if (x < (a + 1.) / (a + b + 2.))
+		return bt * betacf(a, b, x) / a;
+	return 1. - bt * betacf(b, a, 1. - x) / b;
+}
+
+/// Standard normal distribution function.
+inline double normalCdf(double x)
+{
+	return 0.5 * std::erfc(-x / std::sqrt(2.));
+}
+
+/// Standard normal distribution function truncated to [a,b]. Computed from
+/// the upper tail if a > 0, so that it stays accurate far out in the tail.
+inline double truncatedNormalCdf(double x, double a, double b)
+{
+	if (a > 0)
+		return (normalCdf(-a) - normalCdf(-x)) / (normalCdf(-a) - normalCdf(-b));
+	return (normalCdf(x) - normalCdf(a)) / (normalCdf(b) - normalCdf(a));
+}
+
+/// Two-sided p-value of a standard normal test statistic.
+inline double normalPValue(double z)
+{
+	return std::erfc(std::fabs(z) / std::sqrt(2.));
+}
+
+/**
+ * Generalized harmonic number, the sum of k^-s for k = 1,...,n.
+ *
+ * @p n may be HUGE_VAL for s > 1. Terms beyond 1000 are summed with the
+ * Euler-Maclaurin formula.
+ */
+inline double harmonic(double s, double n)
+{
+	const double m = std::min(n, 1000.);
+	double sum = 0.;
+	for (double k = m; k >= 1.; --k)
+		sum += std::pow(k, -s);
+	if (n > m)
+	{
+		auto F = [s](double x)
+		{	return s == 1. ? std::log(x) : std::pow(x, 1. - s) / (1. - s);};
+		auto f = [s](double x)
+		{	return std::pow(x, -s);};
+		auto df = [s](double x)
+		{	return -s * std::pow(x, -s - 1.);};
+		if (n == HUGE_VAL)
+			sum += -F(m) - f(m) / 2. - df(m) / 12.;
+		else
+			sum += F(n) - F(m) + (f(n) - f(m)) / 2. + (df(n) - df(m)) / 12.;
+	}
+	return sum;
+}
+
+/// Complementary Kolmogorov distribution function.
+inline double kolmogorovQ(double lambda)
+{
+	double a2 = -2. * lambda * lambda;
+	double fac = 2., sum = 0., termbf = 0.;
+	for (int j = 1; j <= 100; ++j)
+	{
+		double term = fac * std::exp(a2 * j * j);
+		sum += term;
+		if (std::fabs(term) <= 0.001 * termbf || std::fabs(term) <= 1e-8 * sum)
+			return std::min(1., std::max(0., sum));
+		fac = -fac;
+		termbf = std::fabs(term);
+	}
+	return 1.;
+}
+
+/**
+ * Kolmogorov-Smirnov test of values that should be uniform on (0,1).
+ *
+ * The values are sorted in place.
+ * @return p-value (Stephens' approximation, good for n >= 4)
+ */
+inline double ksUniform(std::vector<double>& u)
+{
+	if (u.empty())
+		return 1.;
+	std::sort(u.begin(), u.end());
+	double n = u.size(), d = 0.;
+	for (std::size_t i = 0; i < u.size(); ++i)
+	{
+		d = std::max(d, (i + 1) / n - u[i]);
+		d = std::max(d, u[i] - i / n);
+	}
+	double sn = std::sqrt(n);
+	return kolmogorovQ((sn + 0.12 + 0.11 / sn) * d);
+}
+
+/**
+ * Chi-square goodness-of-fit test on binned counts.
+ */
+struct ChiSquare
+{
+	std::vector<count_t> counts;
+	std::vector<double> probs;
+
+	explicit ChiSquare(const std::vector<double>& p) :
+			counts(p.size(), 0), probs(p)
+	{
+	}
+	void merge(const ChiSquare& o)
+	{
+		for (std::size_t i = 0; i < counts.size(); ++i)
+			counts[i] += o.counts[i];
+	}
+	double pValue() const
+	{
+		double n = 0., chi2 = 0.;
+		for (std::size_t i = 0; i < counts.size(); ++i)
+			n += counts[i];
+		for (std::size_t i = 0; i < counts.size(); ++i)
+		{
+			double e = n * probs[i];
+			chi2 += (counts[i] - e) * (counts[i] - e) / e;
+		}
+		return gammaQ(0.5 * (counts.size() - 1), 0.5 * chi2);
+	}
+};
+
+/**
+ * Two-level Kolmogorov-Smirnov test.
+ *
+ * Every chunk contributes the p-value of its own KS test; the result is
+ * the p-value of a KS test of these p-values against U(0,1).
+ */
+struct KolmogorovSmirnov
+{
+	std::vector<double> pvalues;
+
+	void add(double p)
+	{
+		pvalues.push_back(p);
+	}
+	void merge(const KolmogorovSmirnov& o)
+	{
+		pvalues.insert(pvalues.end(), o.pvalues.begin(), o.pvalues.end());
+	}
+	double pValue() const
+	{
+		if (pvalues.size() == 1)
+			return pvalues[0];
+		std::vector<double> p(pvalues);
+		return ksUniform(p);
+	}
+};
+
+/**
+ * Lag-1 serial correlation of uniform variates.
+ *
+ * Sums (u[i]-1/2)(u[i+1]-1/2), whose terms are uncorrelated with variance
+ * 1/144, and reports the two-sided p-value of the normalized sum.
+ */
+struct SerialCorrelation
+{
+	double sum;
+	count_t n;
+
+	SerialCorrelation() :
+			sum(0.), n(0)
+	{
+	}
+	void merge(const SerialCorrelation& o)
+	{
+		sum += o.sum;
+		n += o.n;
+	}
+	double pValue() const
+	{
+		return normalPValue(12. * sum / std::sqrt(static_cast<double>(n)));
+	}
+};
+
+/**
+ * Count of events that should be Poisson distributed.
+ */
+struct PoissonCount
+{
+	count_t count;
+	double lambda;
+
+	PoissonCount() :
+			count(0), lambda(0.)
+	{
+	}
+	void merge(const PoissonCount& o)
+	{
+		count += o.count;
+		lambda += o.lambda;
+	}
+	double pValue() const
+	{
+		// P(X <= k) = Q(k+1, lambda), P(X >= k) = P(k, lambda)
+		double lower = gammaQ(count + 1., lambda);
+		double upper = count ? gammaP(static_cast<double>(count), lambda) : 1.;
+		return std::min(1., 2. * std::min(lower, upper));
+	}
+};
+
+/// splitmix64 finalizer, used to derive substream seeds
+inline count_t mix(count_t z)
+{
+	z += 0x9e3779b97f4a7c15ULL;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * Test options
+ */
+struct Options
+{
+	count_t samples; ///< number of variates per test
+	unsigned threads; ///< number of worker threads
+	double alpha; ///< a test fails if its p-value is below alpha
+	unsigned long seed; ///< base seed of all substreams
+
+	Options() :
+			samples(1 << 20), threads(std::thread::hardware_concurrency()),
+			alpha(1e-6), seed(5489)
+	{
+	}
+};
+
+}
+
+/**
+ * Statistical quality battery.
+ *
+ * Runs chi-square, Kolmogorov-Smirnov, serial-correlation, gap and
+ * birthday-spacings tests on the engine and the distributions of the
+ * RandomVariates type @p RNG and prints their p-values.
+ *
+ * The samples of each test are drawn in fixed-size chunks. Every chunk uses
+ * its own generator seeded from the base seed, the test and the chunk
+ * index, so chunks are processed in parallel and the outcome does not depend
+ * on the number of threads.
+ */
+template<class RNG>
+class QualityTests
+{
+public:
+	typedef quality::count_t count_t;
+
+	QualityTests(const quality::Options& o) :
+			opt(o), testno(0), failed(0), start(std::chrono::steady_clock::now())
+	{
+		if (opt.threads == 0)
+			opt.threads = 1;
+		chunk = std::min<count_t>(1 << 20,
+				std::max<count_t>(1 << 14, opt.samples / 64));
+		chunk = std::min(chunk, opt.samples);
+	}
+
+	/**
+	 * Run all tests.
+	 * @return number of failed tests
+	 */
+	unsigned run()
+	{
+		using namespace quality;
+		RNG rng;
+		std::cout << "  Testing " << rng.getName() << " (" << opt.samples
+				<< " samples per test, " << opt.threads << " threads, seed "
+				<< opt.seed << ")\n";
+
+		report("Uniform01 chi-square (100 bins)",
+				parallel(ChiSquare(equal(100)),
+						[](RNG& r, ChiSquare& s, count_t n)
+						{
+							for (count_t i = 0; i < n; ++i)
+								++s.counts[static_cast<int>(r.Uniform01() * 100)];
+						}));
+		report("Uniform01 Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.Uniform01();}, [](double x)
+				{	return x;}));
+		report("Uniform01 serial correlation",
+				parallel(SerialCorrelation(),
+						[](RNG& r, SerialCorrelation& s, count_t n)
+						{
+							double last = r.Uniform01() - 0.5;
+							for (count_t i = 1; i < n; ++i)
+							{
+								double u = r.Uniform01() - 0.5;
+								s.sum += last * u;
+								last = u;
+							}
+							s.n += n - 1;
+						}));
+		report("Uniform01 gap test [0,1/8)", gap());
+		report("Uniform01 birthday spacings", birthday());
+		report("FromTo(-2.5,4) Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.FromTo(-2.5, 4.);}, [](double x)
+				{	return (x + 2.5) / 6.5;}));
+		report("Uniform01_53 Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.Uniform01_53();}, [](double x)
+				{	return x;}));
+		report("Dice(10) chi-square",
+				parallel(ChiSquare(equal(10)),
+						[](RNG& r, ChiSquare& s, count_t n)
+						{
+							for (count_t i = 0; i < n; ++i)
+								++s.counts[r.Dice(10) - 1];
+						}));
+		report("IntFromTo(-3,7) chi-square",
+				parallel(ChiSquare(equal(11)),
+						[](RNG& r, ChiSquare& s, count_t n)
+						{
+							for (count_t i = 0; i < n; ++i)
+								++s.counts[r.IntFromTo(-3, 7) + 3];
+						}));
+		report("IntFromTo(0,1e11) last digits chi-square",
+				parallel(ChiSquare(equal(1000)),
+						[](RNG& r, ChiSquare& s, count_t n)
+						{
+							for (count_t i = 0; i < n; ++i)
+								++s.counts[r.IntFromTo(0LL, 99999999999LL) % 1000];
+						}));
+		std::vector<double> chance(2);
+		chance[0] = 0.3;
+		chance[1] = 0.7;
+		report("Chance(0.3) chi-square",
+				parallel(ChiSquare(chance),
+						[](RNG& r, ChiSquare& s, count_t n)
+						{
+							for (count_t i = 0; i < n; ++i)
+								++s.counts[r.Chance(0.3) ? 0 : 1];
+						}));
+		report("Chances(0.3) bit mask chi-square",
+				parallel(ChiSquare(chance),
+						[](RNG& r, ChiSquare& s, count_t n)
+						{
+							std::vector<uint64_t> mask((n + 63) / 64);
+							r.Chances(0.3, n, &mask[0]);
+							for (count_t i = 0; i < n; ++i)
+								++s.counts[(mask[i / 64] >> (i % 64)) & 1 ? 0 : 1];
+						}));
+		report("FairChance() chi-square",
+				parallel(ChiSquare(equal(2)),
+						[](RNG& r, ChiSquare& s, count_t n)
+						{
+							for (count_t i = 0; i < n; ++i)
+								++s.counts[r.FairChance() ? 0 : 1];
+						}));
+		report("RandomBits(5) chi-square",
+				parallel(ChiSquare(equal(32)),
+						[](RNG& r, ChiSquare& s, count_t n)
+						{
+							for (count_t i = 0; i < n; ++i)
+								++s.counts[r.RandomBits(5)];
+						}));
+		static double choices[5] =
+		{ 0.1, 0.25, 0.05, 0.4, 0.2 };
+		report("Choices(5) chi-square",
+				parallel(ChiSquare(std::vector<double>(choices, choices + 5)),
+						[](RNG& r, ChiSquare& s, count_t n)
+						{
+							for (count_t i = 0; i < n; ++i)
+								++s.counts[r.Choices(choices, 5)];
+						}));
+		report("Normal01Polar Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.Normal01Polar();}, normalCdf));
+		report("GaussianPolar(1.5,4) Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.GaussianPolar(1.5, 4.);}, [](double x)
+				{	return normalCdf((x - 1.5) / 2.);}));
+		report("TruncatedNormal[-0.5,1] Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.TruncatedNormal(0., 1., -0.5, 1.);}, [](double x)
+				{	return truncatedNormalCdf(x, -0.5, 1.);}));
+		report("TruncatedNormal[-inf,2] Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.TruncatedNormal(0., 1., -HUGE_VAL, 2.);}, [](double x)
+				{	return truncatedNormalCdf(x, -HUGE_VAL, 2.);}));
+		report("TruncatedNormal[.3,inf] Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.TruncatedNormal(0., 1., 0.3, HUGE_VAL);}, [](double x)
+				{	return truncatedNormalCdf(x, 0.3, HUGE_VAL);}));
+		report("TruncatedNormal[-9,-6] Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.TruncatedNormal(0., 1., -9., -6.);}, [](double x)
+				{	return 1. - truncatedNormalCdf(-x, 6., 9.);}));
+		report("TruncatedNormal[3,3.2] Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.TruncatedNormal(0., 1., 3., 3.2);}, [](double x)
+				{	return truncatedNormalCdf(x, 3., 3.2);}));
+		report("Exponential(0.7) Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.Exponential(0.7);}, [](double x)
+				{	return 1. - std::exp(-x / 0.7);}));
+		report("Gamma(0.4,1.3) Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.Gamma(0.4, 1.3);}, [](double x)
+				{	return gammaP(0.4, x / 1.3);}));
+		report("Gamma(2.7,0.8) Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.Gamma(2.7, 0.8);}, [](double x)
+				{	return gammaP(2.7, x / 0.8);}));
+		report("Beta(0.7,2.2) Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.Beta(0.7, 2.2);}, [](double x)
+				{	return betaI(0.7, 2.2, x);}));
+		report("Dirichlet(.5,1.5,2) x1 Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	const double a[3] = { 0.5, 1.5, 2. }; double x[3];
+					r.Dirichlet(a, 3, x); return x[0];}, [](double x)
+				{	return betaI(0.5, 3.5, x);}));
+		report("Uniform01f Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.Uniform01f();}, [](double x)
+				{	return x;}));
+		report("Normal01f Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.Normal01f();}, normalCdf));
+		report("Exponentialf(0.7) Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	return r.Exponentialf(0.7f);}, [](double x)
+				{	return 1. - std::exp(-x / 0.7f);}));
+		report("UnitVector3 z Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	double x, y, z; r.UnitVector3(x, y, z); return z;},
+						[](double z)
+						{	return (z + 1.) / 2.;}));
+		report("UnitVectors3 azimuth Kolmogorov-Smirnov",
+				ksBatch(3, [](RNG& r, double* out, count_t n)
+				{	r.UnitVectors(out, n, 3);}, [](const double* v, count_t n)
+				{	return std::atan2(v[n], v[0]) / (2. * PI) + 0.5;}));
+		report("UnitVectors(4) x4 Kolmogorov-Smirnov",
+				ksBatch(4, [](RNG& r, double* out, count_t n)
+				{	r.UnitVectors(out, n, 4);}, [](const double* v, count_t n)
+				{	const double x = v[3 * n];
+					return 0.5 + (x * std::sqrt(1. - x * x) + std::asin(x)) / PI;}));
+		report("InBall(4) radius Kolmogorov-Smirnov",
+				ks([](RNG& r)
+				{	double x[4]; r.InBall(x, 4);
+					return x[0] * x[0] + x[1] * x[1] + x[2] * x[2] + x[3] * x[3];},
+						[](double r2)
+						{	return r2 * r2;}));
+
+		report("Zipf(1.2,100) chi-square", zipf(1.2, 100.));
+		report("Zipf(0.8,1e9) chi-square", zipf(0.8, 1e9));
+		report("Zipf(1,1e9) chi-square", zipf(1., 1e9));
+		report("Zeta(2.5) chi-square", zipf(2.5, HUGE_VAL));
+		report("Zeta(1.1) chi-square", zipf(1.1, HUGE_VAL));
+		report("Binomial(20,0.3) chi-square", binomial(20, 0.3, [](RNG& r)
+		{	return r.Binomial(20, 0.3);}));
+		report("Binomial(1000,0.4) chi-square", binomial(1000, 0.4, [](RNG& r)
+		{	return r.Binomial(1000, 0.4);}));
+		report("Binomial(300,0.9) chi-square", binomial(300, 0.9, [](RNG& r)
+		{	return r.Binomial(300, 0.9);}));
+		report("Multinomial(50,.2/.5/.3) n2 chi-square",
+				binomial(50, 0.5, [](RNG& r)
+				{	const double p[3] = { 0.2, 0.5, 0.3 }; int k[3];
+					r.Multinomial(50, p, 3, k); return k[1];}));
+
+		std::cout << "    " << failed << " of " << testno << " tests failed\n\n";
+		return failed;
+	}
+
+private:
+	quality::Options opt;
+	count_t chunk; ///< samples per chunk
+	unsigned testno; ///< index of the current test
+	unsigned failed; ///< number of failed tests
+	std::chrono::steady_clock::time_point start; ///< end of the last test
+
+	static std::vector<double> equal(int bins)
+	{
+		return std::vector<double>(bins, 1. / bins);
+	}
+
+	/**
+	 * Chi-square test of Zipf(s,n), or Zeta(s) if @p n is HUGE_VAL.
+	 *
+	 * The values 1 to 100 have bins of their own (up to n), larger values
+	 * are binned by decades. Bins at the tail are merged until each has a
+	 * probability of at least 1e-4.
+	 */
+	double zipf(double s, double n)
+	{
+		using namespace quality;
+		std::vector<double> edges;
+		for (double k = 1.; k <= 100. && k <= n; ++k)
+			edges.push_back(k);
+		for (double e = 1000.; e <= n && e < 1e15; e *= 10.)
+			edges.push_back(e);
+		const double total = harmonic(s, n);
+		std::vector<double> probs;
+		for (std::size_t i = 0; i < edges.size(); ++i)
+		{
+			double hi = i + 1 < edges.size() ? edges[i + 1] - 1. : n;
+			probs.push_back(
+					(harmonic(s, hi) - harmonic(s, edges[i] - 1.)) / total);
+		}
+		while (probs.size() > 2 && probs.back() < 1e-4)
+		{
+			probs[probs.size() - 2] += probs.back();
+			probs.pop_back();
+			edges.pop_back();
+		}
+		return parallel(ChiSquare(probs),
+				[s, n, edges](RNG& r, ChiSquare& st, count_t m)
+				{
+					for (count_t i = 0; i < m; ++i)
+					{
+						double k = n == HUGE_VAL ? r.Zeta(s)
+								: static_cast<double>(r.Zipf(s,
+												static_cast<unsigned long>(n)));
+						++st.counts[std::upper_bound(edges.begin(), edges.end(), k)
+								- edges.begin() - 1];
+					}
+				});
+	}
+
+	/**
+	 * Chi-square test of integers drawn by @p draw against Binomial(n,p).
+	 *
+	 * Each value has a bin of its own, except for the tails, which are
+	 * merged into one bin each with a probability of at least 1e-4.
+	 */
+	template<class Draw>
+	double binomial(int n, double p, Draw draw)
+	{
+		using quality::ChiSquare;
+		std::vector<double> pmf(n + 1);
+		for (int k = 0; k <= n; ++k)
+			pmf[k] = std::exp(std::lgamma(n + 1.) - std::lgamma(k + 1.)
+					- std::lgamma(n - k + 1.) + k * std::log(p)
+					+ (n - k) * std::log1p(-p));
+		// values up to lo and from hi on share the tail bins
+		int lo = 0, hi = n;
+		for (double t = pmf[0]; t < 1e-4 && lo < n; t += pmf[++lo])
+			;
+		for (double t = pmf[n]; t < 1e-4 && hi > lo + 1; t += pmf[--hi])
+			;
+		std::vector<double> probs(hi - lo + 1, 0.);
+		for (int k = 0; k <= n; ++k)
+			probs[std::min(std::max(k, lo), hi) - lo] += pmf[k];
+		return parallel(ChiSquare(probs),
+				[lo, hi, &draw](RNG& r, ChiSquare& s, count_t m)
+				{
+					for (count_t i = 0; i < m; ++i)
+					{
+						const int k = draw(r);
+						++s.counts[std::min(std::max(k, lo), hi) - lo];
+					}
+				});
+	}
+
+	/// Seed of chunk @p c of the current test
+	unsigned long substream(count_t c) const
+	{
+		using quality::mix;
+		return static_cast<unsigned long>(mix(mix(mix(opt.seed) ^ testno) ^ c)
+				& 0xffffffffUL);
+	}
+
+	/**
+	 * Run @p sample on all chunks of the current test in parallel.
+	 *
+	 * @param proto Empty statistic, copied for each chunk
+	 * @param sample Function (RNG&, Stat&, count_t n) adding n variates
+	 * drawn from the RNG to the statistic
+	 * @return p-value of the merged statistic
+	 */
+	template<class Stat, class Sample>
+	double parallel(const Stat& proto, Sample sample)
+	{
+		count_t nchunks = (opt.samples + chunk - 1) / chunk;
+		std::vector<Stat> stats(nchunks, proto);
+		std::atomic<count_t> next(0);
+		auto worker = [&]()
+		{
+			count_t c;
+			while ((c = next++) < nchunks)
+			{
+				RNG rng;
+				rng.Seed(substream(c));
+				sample(rng, stats[c], std::min(chunk, opt.samples - c * chunk));
+			}
+		};
+		std::vector<std::thread> pool;
+		for (unsigned t = 1; t < opt.threads && t < nchunks; ++t)
+			pool.push_back(std::thread(worker));
+		worker();
+		for (std::size_t t = 0; t < pool.size(); ++t)
+			pool[t].join();
+
+		Stat total(proto);
+		for (count_t c = 0; c < nchunks; ++c)
+			total.merge(stats[c]);
+		return total.pValue();
+	}
+
+	/// Two-level KS test of variates drawn by @p draw against @p cdf
+	template<class Draw, class Cdf>
+	double ks(Draw draw, Cdf cdf)
+	{
+		using quality::KolmogorovSmirnov;
+		return parallel(KolmogorovSmirnov(),
+				[&](RNG& r, KolmogorovSmirnov& s, count_t n)
+				{
+					std::vector<double> u(n);
+					for (count_t i = 0; i < n; ++i)
+						u[i] = cdf(draw(r));
+					s.add(quality::ksUniform(u));
+				});
+	}
+
+	/**
+	 * Two-level KS test of batches of vectors in structure-of-arrays layout.
+	 *
+	 * @param d number of components of a vector
+	 * @param fill Function (RNG&, double* out, count_t n) writing n vectors
+	 * @param cdf Function (const double* v, count_t n) of the first
+	 * component v[0] of a vector, whose component k is v[k * n]
+	 */
+	template<class Fill, class Cdf>
+	double ksBatch(unsigned int d, Fill fill, Cdf cdf)
+	{
+		using quality::KolmogorovSmirnov;
+		return parallel(KolmogorovSmirnov(),
+				[&](RNG& r, KolmogorovSmirnov& s, count_t n)
+				{
+					std::vector<double> v(n * d), u(n);
+					fill(r, &v[0], n);
+					for (count_t i = 0; i < n; ++i)
+						u[i] = cdf(&v[i], n);
+					s.add(quality::ksUniform(u));
+				});
+	}
+
+	/// Gap test: lengths of runs outside [0,1/8), 32 bins plus tail
+	double gap()
+	{
+		using quality::ChiSquare;
+		const int t = 32;
+		const double p = 0.125;
+		std::vector<double> probs(t + 1);
+		for (int r = 0; r < t; ++r)
+			probs[r] = p * std::pow(1. - p, r);
+		probs[t] = std::pow(1. - p, t);
+		return parallel(ChiSquare(probs), [=](RNG& r, ChiSquare& s, count_t n)
+		{
+			int g = 0;
+			for (count_t i = 0; i < n; ++i)
+			{
+				if (r.Uniform01() < p)
+				{
+					++s.counts[std::min(g, t)];
+					g = 0;
+				}
+				else
+					++g;
+			}
+		});
+	}
+
+	/**
+	 * Birthday spacings: 512 birthdays in a year of 2^24 days. The number
+	 * of repeated spacings is Poisson distributed with mean 2.
+	 */
+	double birthday()
+	{
+		using quality::PoissonCount;
+		return parallel(PoissonCount(), [](RNG& r, PoissonCount& s, count_t n)
+		{
+			const int m = 512;
+			unsigned long days[m];
+			for (count_t trial = 0; trial < n / m; ++trial)
+			{
+				for (int i = 0; i < m; ++i)
+					days[i] = static_cast<unsigned long>(r.Uniform01() * 16777216.);
+				std::sort(days, days + m);
+				for (int i = m - 1; i > 0; --i)
+					days[i] -= days[i - 1];
+				std::sort(days, days + m);
+				for (int i = 1; i < m; ++i)
+					if (days[i] == days[i - 1])
+						++s.count;
+				s.lambda += 2.;
+			}
+		});
+	}
+
+	void report(const char* name, double p)
+	{
+		std::chrono::steady_clock::time_point now =
+				std::chrono::steady_clock::now();
+		double secs = std::chrono::duration<double>(now - start).count();
+		start = now;
+		bool ok = p >= opt.alpha;
+		if (!ok)
+			++failed;
+		++testno;
+		std::cout << "    " << std::left << std::setw(42) << name << std::right
+				<< " p = " << std::setw(10) << std::setprecision(4) << p
+				<< std::setw(8) << std::setprecision(3) << secs << "s"
+				<< (ok ? "   ok\n" : "   FAILED\n") << std::flush;
+	}
+};
+
+#endif /* QUALITYTESTS_H_ */
@@ -0,0 +1,1088 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  testEngines.cpp
+ *    Description:  Deterministic checks of the engine interfaces, e.g.
+ *                  that checkpoints restore the exact sequence of variates.
+ *                  Returns a non-zero exit status on failure.
+ *
+ * ==========================================================================
+ */
+#define MYRNG_STATS
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <myrng.h>
+#include <RecordEngine.h>
+#include <ReplayEngine.h>
+#include <BufferedEngine.h>
+#include <EnsembleEngine.h>
+#include <EnsembleVariates.h>
+#include <AnyEngine.h>
+#include <AntitheticEngine.h>
+#include <LatinHypercubeEngine.h>
+#include <MultivariateNormal.h>
+#include <QuasiVariates.h>
+#include <StreamArena.h>
+#include <util.h>
+
+static unsigned failed = 0;
+
+static void check(bool ok, const char* engine, const char* what)
+{
+	std::cout << "    " << engine << ": " << what << (ok ? "   ok\n" : "   FAILED\n");
+	if (!ok)
+		++failed;
+}
+
+/// Shape of the Gamma variates. Volatile, so that the compiler cannot fold
+/// pow() and log() into constants in some instantiations of draw() but not
+/// in others, which may change the last bit of the result.
+static volatile double shape = 0.5;
+
+/// Draw a mix of variates that touches the cached polar variate
+template<class RNG>
+static double draw(RNG& rng)
+{
+	double x = rng.Uniform01();
+	x += rng.Normal01Polar();
+	return x + rng.Gamma(shape, 2.);
+}
+
+template<class RNG, class Other>
+static void testCheckpoint()
+{
+	RNG rng;
+	rng.Seed(4357);
+	const char* name = rng.getName();
+	check(rng.getSeed() == 4357, name, "getSeed() returns the seed");
+
+	RNG reseeded;
+	reseeded.Seed(4357);
+	reseeded.Uniform01();
+	reseeded.Seed(4357);
+	check(reseeded.Uniform01() == rng.Uniform01(), name,
+			"Seed() restarts the sequence");
+	rng.Seed(4357);
+
+	for (int i = 0; i < 1000; ++i)
+		draw(rng);
+	rng.Normal01Polar(); // leave a cached variate behind
+	std::stringstream buf;
+	rng.save(buf);
+	double expected[100];
+	for (int i = 0; i < 100; ++i)
+		expected[i] = draw(rng);
+
+	RNG restored;
+	restored.Seed(1);
+	bool same = static_cast<bool>(restored.load(buf));
+	for (int i = 0; i < 100; ++i)
+		same = same && draw(restored) == expected[i];
+	check(same && restored.getSeed() == 4357, name,
+			"load() restores the exact sequence");
+
+	Other other;
+	buf.clear();
+	buf.seekg(0);
+	double before = RNG(restored).Uniform01();
+	check(!other.load(buf), name, "load() rejects a foreign state");
+	buf.clear();
+	buf.seekg(0);
+	std::string truncated = buf.str().substr(0, buf.str().size() / 2);
+	std::istringstream in(truncated);
+	check(!restored.load(in) && restored.Uniform01() == before, name,
+			"load() leaves the state unchanged on error");
+}
+
+template<class Engine, class Other>
+static void testRecordReplay()
+{
+	const char* file = "testEngines.rec";
+	myrng::RandomVariates<myrng::RecordEngine<Engine> > rec;
+	const char* name = rec.getName();
+	rec.Seed(99);
+	double expected[500];
+	bool ok = rec.record(file);
+	for (int i = 0; i < 500; ++i)
+		expected[i] = draw(rec);
+	rec.discard(10);
+	typename Engine::result_type block[300];
+	rec.fill(block, 300);
+	ok = rec.stop() && ok;
+
+	myrng::RandomVariates<Engine> plain;
+	plain.Seed(99);
+	bool same = true;
+	for (int i = 0; i < 500; ++i)
+		same = same && draw(plain) == expected[i];
+	check(ok && same, name, "recording does not change the sequence");
+
+	myrng::RandomVariates<myrng::ReplayEngine<Engine> > replay;
+	same = replay.open(file);
+	for (int i = 0; i < 500; ++i)
+		same = same && draw(replay) == expected[i];
+	check(same, name, "replay reproduces the recorded sequence");
+	same = true;
+	for (int i = 0; i < 10; ++i)
+		same = same && replay() == plain();
+	for (int i = 0; i < 300; ++i)
+		same = same && replay() == block[i] && block[i] == plain();
+	check(same && replay.laps() == 0 && replay.position() == replay.size(),
+			name, "fill() and discard() are recorded");
+
+	myrng::RandomVariates<myrng::ReplayEngine<Other> > foreign;
+	check(!foreign.open(file), name,
+			"replay rejects a recording of another engine");
+	std::remove(file);
+
+	// /dev/full fails every write with ENOSPC
+	if (rec.record("/dev/full"))
+	{
+		for (int i = 0; i < 10000; ++i)
+			rec();
+		check(!rec.stop() && rec.failed(), name,
+				"stop() reports a failed write");
+	}
+}
+
+template<class Engine>
+static void testBuffered()
+{
+	myrng::RandomVariates<myrng::BufferedEngine<Engine, 256> > buffered;
+	myrng::RandomVariates<Engine> plain;
+	const char* name = plain.getName();
+	buffered.Seed(7);
+	plain.Seed(7);
+	bool same = true;
+	for (int i = 0; i < 100000; ++i)
+		same = same && draw(buffered) == draw(plain);
+	check(same, name, "buffering does not change the sequence");
+
+	buffered.discard(100);
+	plain.discard(100);
+	same = buffered() == plain();
+	buffered.discard(100000);
+	plain.discard(100000);
+	check(same && buffered() == plain(), name,
+			"discard() skips buffered numbers first");
+
+	std::stringstream buf;
+	buffered.save(buf);
+	double expected[100];
+	for (int i = 0; i < 100; ++i)
+		expected[i] = draw(buffered);
+	same = static_cast<bool>(buffered.load(buf));
+	for (int i = 0; i < 100; ++i)
+		same = same && draw(buffered) == expected[i];
+	check(same, name, "load() restores the buffered sequence");
+}
+
+/// Compare with the Mersenne Twisters of the standard library
+template<class RNG, class Std>
+static void testReference()
+{
+	RNG rng;
+	Std ref(5489);
+	rng.Seed(5489);
+	bool same = true;
+	for (int i = 0; i < 10000; ++i)
+	{
+		if (i == 5000)
+			rng.setIncremental(true);
+		same = same && rng() == ref();
+	}
+	check(same, rng.getName(), "matches the reference sequence");
+}
+
+/// Use the generator as UniformRandomBitGenerator of the standard library
+template<class RNG>
+static void testStandard()
+{
+	static_assert(RNG::min() == 0 && RNG::max() == ~typename RNG::result_type(0),
+			"raw numbers cover all bits");
+	RNG raw, rng;
+	raw.Seed(11);
+	rng.Seed(11);
+	const char* name = rng.getName();
+	bool same = true;
+	for (int i = 0; i < 1000; ++i)
+		same = same && RNG::canonical(raw()) == rng.Uniform01();
+	check(same, name, "Uniform01() converts the raw numbers");
+
+	std::vector<int> v(100);
+	for (int i = 0; i < 100; ++i)
+		v[i] = i;
+	std::shuffle(v.begin(), v.end(), rng);
+	std::uniform_int_distribution<int> dice(1, 6);
+	int sum = 0;
+	for (int i = 0; i < 600; ++i)
+		sum += dice(rng);
+	check(!std::is_sorted(v.begin(), v.end()) && sum > 1800 && sum < 2400,
+			name, "works with <random> and std::shuffle");
+}
+
+static void testStats()
+{
+	myrng::MT19937 rng;
+	rng.Seed(3);
+	rng.resetStats();
+	for (int i = 0; i < 3 * 624; ++i)
+		rng.Uniform01();
+	myrng::Stats s = rng.stats();
+	check(s.words == 3 * 624 && s.calls[myrng::Stats::UNIFORM01] == 3 * 624
+			&& s.refills == 3, "MT19937", "stats() counts words and refills");
+
+	rng.resetStats();
+	for (int i = 0; i < 1000; ++i)
+		rng.Beta(0.5, 2.);
+	s = rng.stats();
+	check(s.calls[myrng::Stats::BETA] == 1000
+			&& s.calls[myrng::Stats::GAMMA] == 2000
+			&& s.gammaTries >= 2000 && s.polarTries > 0
+			&& s.words == s.calls[myrng::Stats::UNIFORM01]
+			&& s.calls[myrng::Stats::EXPONENTIAL] == 0, "MT19937",
+			"stats() counts calls and rejections");
+	std::ostringstream report;
+	report << s;
+	check(report.str().find("Gamma") != std::string::npos, "MT19937",
+			"stats() can be printed");
+
+	rng.resetStats();
+	bool inside = true;
+	for (int i = 0; i < 1000; ++i)
+	{
+		const double x = rng.TruncatedNormal(10., 3., 40., 41.);
+		const double y = rng.TruncatedNormal(10., 3., -HUGE_VAL, -20.);
+		inside = inside && x >= 40. && x <= 41. && y <= -20.;
+	}
+	s = rng.stats();
+	check(inside && s.calls[myrng::Stats::TRUNCATEDNORMAL] == 2000
+			&& s.truncatedTries < 4000, "MT19937",
+			"TruncatedNormal() accepts most candidates in the tails");
+
+	rng.resetStats();
+	long sum = 0;
+	for (int i = 0; i < 1000; ++i)
+		sum += rng.Binomial(100000L, 0.7) + rng.Binomial(30L, 0.1);
+	s = rng.stats();
+	check(sum > 1000 * 70000 && s.calls[myrng::Stats::BINOMIAL] == 2000
+			&& s.binomialTries < 1300, "MT19937",
+			"Binomial() accepts most candidates");
+}
+
+/// Single precision variates and their batch forms
+template<class RNG>
+static void testFloat()
+{
+	RNG scalar, batch;
+	scalar.Seed(21);
+	batch.Seed(21);
+	const char* name = scalar.getName();
+	float a[101], b[101];
+	bool same = true, range = true;
+	for (int k = 0; k < 20; ++k)
+	{
+		for (int i = 0; i < 101; ++i)
+			a[i] = scalar.Uniform01f();
+		batch.Uniform01f(b, 101);
+		for (int i = 0; i < 101; ++i)
+		{
+			same = same && a[i] == b[i];
+			range = range && a[i] >= 0.f && a[i] < 1.f;
+		}
+		for (int i = 0; i < 101; ++i)
+			a[i] = scalar.Normal01f();
+		batch.Normal01f(b, 101);
+		for (int i = 0; i < 101; ++i)
+			same = same && a[i] == b[i];
+		for (int i = 0; i < 101; ++i)
+			a[i] = scalar.Exponentialf(2.f);
+		batch.Exponentialf(b, 101, 2.f);
+		for (int i = 0; i < 101; ++i)
+		{
+			same = same && a[i] == b[i];
+			range = range && a[i] >= 0.f && a[i] < 1e3f;
+		}
+	}
+	check(same, name, "float batches equal repeated scalar calls");
+	check(range, name, "float variates are in range");
+}
+
+/// Lanes of the ensemble engine reproduce scalar generators
+template<class Params, std::size_t Lanes>
+static void testEnsemble()
+{
+	typedef myrng::BasicWELLEnsembleEngine<Params, Lanes> Engine;
+	myrng::EnsembleVariates<Engine> ensemble;
+	myrng::RandomVariates<myrng::BasicWELLEngine<Params> > scalar[Lanes];
+	const char* name = ensemble.getName();
+	ensemble.Seed(17);
+	for (std::size_t k = 0; k < Lanes; ++k)
+		scalar[k].Seed(Engine::laneSeed(17, k));
+	double u[Lanes];
+	bool same = true;
+	for (int i = 0; i < 2000; ++i)
+	{
+		ensemble.Uniform01(u);
+		for (std::size_t k = 0; k < Lanes; ++k)
+			same = same && u[k] == scalar[k].Uniform01();
+	}
+	check(same, name, "ensemble lanes equal scalar engines");
+
+	std::stringstream fresh[2];
+	for (int i = 0; i < 2; ++i)
+	{
+		myrng::EnsembleVariates<Engine> e;
+		e.Seed(17);
+		e.save(fresh[i]);
+	}
+	check(fresh[0].str() == fresh[1].str(), name,
+			"save() before the first variate is deterministic");
+
+	double sum = 0, sum2 = 0;
+	const int n = 20000;
+	for (int i = 0; i < n; ++i)
+	{
+		ensemble.Normal01(u);
+		for (std::size_t k = 0; k < Lanes; ++k)
+		{
+			sum += u[k];
+			sum2 += u[k] * u[k];
+		}
+	}
+	const double mean = sum / (n * Lanes), var = sum2 / (n * Lanes) - mean * mean;
+	check(std::fabs(mean) < 0.01 && std::fabs(var - 1) < 0.02, name,
+			"ensemble Normal01() has mean 0 and variance 1");
+
+	ensemble.Normal01(u); // leave cached variates behind
+	std::stringstream buf;
+	ensemble.save(buf);
+	double expected[3][Lanes];
+	for (int i = 0; i < 3; ++i)
+		ensemble.Normal01(expected[i]);
+	same = static_cast<bool>(ensemble.load(buf));
+	for (int i = 0; i < 3; ++i)
+	{
+		ensemble.Normal01(u);
+		for (std::size_t k = 0; k < Lanes; ++k)
+			same = same && u[k] == expected[i][k];
+	}
+	check(same, name, "ensemble load() restores the exact sequence");
+}
+
+/// The bit buffer serves the bits of the raw numbers in order
+template<class RNG>
+static void testBits()
+{
+	typedef typename RNG::result_type word;
+	const unsigned digits = std::numeric_limits<word>::digits;
+	RNG raw, bits;
+	raw.Seed(8);
+	bits.Seed(8);
+	const char* name = raw.getName();
+	bool same = true;
+	for (int i = 0; i < 1000; ++i)
+	{
+		word y1 = raw(), y2 = raw();
+		same = same && bits.RandomBits(3) == (y1 & 7);
+		same = same && bits.RandomBit() == ((y1 >> 3) & 1);
+		same = same
+				&& bits.RandomBits(digits - 2)
+						== ((y1 >> 4) | ((y2 & 3) << (digits - 4)));
+		same = same && bits.RandomBits(digits - 2) == (y2 >> 2);
+	}
+	check(same, name, "RandomBits() serves the raw bits in order");
+
+	same = true;
+	for (int i = 0; i < 1000; ++i)
+		same = same && bits.Chance() == (raw.Uniform01() <= 0.5);
+	check(same, name, "Chance() draws a uniform, as in version 1.5");
+
+	bits.RandomBits(5);
+	std::stringstream buf;
+	bits.save(buf);
+	word expected[100];
+	for (int i = 0; i < 100; ++i)
+		expected[i] = bits.RandomBits(i % digits + 1);
+	same = static_cast<bool>(bits.load(buf));
+	for (int i = 0; i < 100; ++i)
+		same = same && bits.RandomBits(i % digits + 1) == expected[i];
+	check(same, name, "load() restores the bit buffer");
+}
+
+/// Batches of Chance() outcomes equal repeated calls
+template<class RNG>
+static void testChances()
+{
+	RNG scalar, batch;
+	scalar.Seed(48);
+	batch.Seed(48);
+	const char* name = scalar.getName();
+	const std::size_t n = 1000;
+	std::vector<double> p(n);
+	for (std::size_t i = 0; i < n; ++i)
+		p[i] = (i % 11) / 10.;
+	std::vector<uint64_t> bits((n + 63) / 64);
+	std::vector<uint8_t> bytes(n);
+	batch.Chances(&p[0], n, &bits[0]);
+	bool same = bits.back() >> (n % 64) == 0;
+	for (std::size_t i = 0; i < n; ++i)
+		same = same && ((bits[i / 64] >> (i % 64)) & 1) == scalar.Chance(p[i]);
+	batch.Chances(&p[0], n, &bytes[0]);
+	for (std::size_t i = 0; i < n; ++i)
+		same = same && bytes[i] == scalar.Chance(p[i]);
+	check(same, name, "Chances() with probabilities equals Chance()");
+
+	static const double shared[5] =
+	{ 0., 0.3, 1., -1., 1e-12 };
+	same = true;
+	for (int k = 0; k < 5; ++k)
+	{
+		batch.Chances(shared[k], n, &bits[0]);
+		for (std::size_t i = 0; i < n; ++i)
+			same = same
+					&& ((bits[i / 64] >> (i % 64)) & 1) == scalar.Chance(shared[k]);
+		batch.Chances(shared[k], n, &bytes[0]);
+		for (std::size_t i = 0; i < n; ++i)
+			same = same && bytes[i] == scalar.Chance(shared[k]);
+	}
+	check(same, name, "Chances() with one probability equals Chance()");
+}
+
+/// An engine selected by name gives the variates of the engine itself
+template<class RNG>
+static void testAny()
+{
+	RNG direct;
+	myrng::AnyRNG any;
+	const char* name = direct.getName();
+	bool same = any.select(name) && std::string(any.getName()) == name;
+	direct.Seed(21);
+	any.Seed(21);
+	for (int i = 0; i < 3000; ++i)
+		same = same && draw(direct) == draw(any)
+				&& direct.Uniform01() == any.Uniform01();
+	check(same, name, "AnyEngine gives the same variates");
+
+	std::stringstream buf;
+	any.save(buf);
+	std::vector<double> expected(5000);
+	any.Uniform01(&expected[0], expected.size());
+	myrng::AnyRNG restored;
+	same = restored.select("WELL512a") && restored.load(buf)
+			&& std::string(restored.getName()) == name;
+	for (std::size_t i = 0; i < expected.size(); ++i)
+		same = same && restored.Uniform01() == expected[i];
+	any.discard(123456);
+	direct.discard(5000 + 123456);
+	for (int i = 0; i < 100; ++i)
+		same = same && any() == direct();
+	check(same, name, "AnyEngine load() and discard()");
+}
+
+/// discard() jumps ahead exactly, and the parallel fill matches the serial one
+template<class RNG>
+static void testJump()
+{
+	RNG jumped, stepped;
+	jumped.Seed(12);
+	stepped.Seed(12);
+	const char* name = jumped.getName();
+	bool same = true;
+	for (int i = 0; i < 3; ++i)
+	{
+		const unsigned long long z = 50000 + 777 * i;
+		jumped.discard(z);
+		for (unsigned long long k = 0; k < z; ++k)
+			stepped();
+		for (int k = 0; k < 1000 + 100 * i; ++k)
+			same = same && jumped() == stepped();
+	}
+	check(same, name, "discard() equals as many calls of operator()");
+
+	const std::size_t n = 100001;
+	std::vector<double> serial(n), parallel(n);
+	std::stringstream buf;
+	stepped.save(buf);
+	const std::string state = buf.str();
+	stepped.Uniform01(&serial[0], n);
+	const double next = stepped.Uniform01();
+	same = true;
+	for (unsigned int threads = 2; threads <= 5; threads += 3)
+	{
+		RNG rng;
+		std::stringstream in(state);
+		same = same && rng.load(in);
+		rng.Uniform01(&parallel[0], n, threads);
+		same = same && parallel == serial && rng.Uniform01() == next;
+	}
+	check(same, name, "parallel Uniform01() equals the serial fill");
+}
+
+/// Uniform01_53() and IntFromTo() have full resolution
+template<class RNG>
+static void testResolution()
+{
+	RNG rng;
+	rng.Seed(42);
+	const char* name = rng.getName();
+	bool low = false; // Uniform01_53() has random bits below 2^-32
+	for (int i = 0; i < 100; ++i)
+	{
+		const double u = rng.Uniform01_53();
+		low = low || std::fmod(u * 4294967296., 1.) != 0.5;
+	}
+	std::vector<bool> seen(256);
+	bool inside = true;
+	const long long top = 1LL << 40;
+	for (int i = 0; i < 20000; ++i)
+	{
+		const long long k = rng.IntFromTo(-3LL, top);
+		const unsigned long long f = rng.Dice(1ULL << 36);
+		inside = inside && k >= -3 && k <= top && f >= 1 && f <= (1ULL << 36);
+		seen[k & 255] = true;
+	}
+	check(low, name, "Uniform01_53() has 53 random bits");
+	check(inside && std::count(seen.begin(), seen.end(), true) == 256, name,
+			"IntFromTo() reaches every integer of a range of 2^40");
+}
+
+/// The batch forms of the unit vectors give the same vectors as the scalar forms
+template<class RNG>
+static void testVectors()
+{
+	RNG scalar, batch;
+	scalar.Seed(31);
+	batch.Seed(31);
+	const char* name = scalar.getName();
+	bool same = true;
+	const std::size_t n = 1000;
+	for (unsigned int d = 2; d <= 5; ++d)
+	{
+		std::vector<double> soa(n * d), v(d);
+		batch.UnitVectors(&soa[0], n, d);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			scalar.UnitVector(&v[0], d);
+			for (unsigned int k = 0; k < d; ++k)
+				same = same && v[k] == soa[k * n + i];
+		}
+	}
+	same = same && scalar() == batch();
+	check(same, name, "UnitVectors() equals repeated UnitVector()");
+}
+
+/// The graph generators write valid edges in lexicographic order
+static void testGraphs()
+{
+	typedef std::pair<unsigned, unsigned> edge;
+	myrng::WELL1024a rng;
+	rng.Seed(9);
+	bool ok = true;
+	for (unsigned m = 0; m <= 45; ++m)
+	{
+		std::vector<edge> e;
+		myrng::util::erdos_renyi_gnm(10u, m, std::back_inserter(e), rng);
+		ok = ok && e.size() == m;
+		for (std::size_t i = 0; i < e.size(); ++i)
+			ok = ok && e[i].second < e[i].first && e[i].first < 10
+					&& (i == 0 || e[i - 1] < e[i]);
+	}
+	std::vector<edge> e;
+	myrng::util::erdos_renyi_gnm(100000u, 3000u, std::back_inserter(e), rng);
+	for (std::size_t i = 1; i < e.size(); ++i)
+		ok = ok && e[i].second < e[i].first && e[i - 1] < e[i];
+	check(ok && e.size() == 3000, "util", "erdos_renyi_gnm() gives m distinct edges");
+
+	e.clear();
+	myrng::util::erdos_renyi_gnp(10u, 0., std::back_inserter(e), rng);
+	ok = e.empty();
+	myrng::util::erdos_renyi_gnp(10u, 1., std::back_inserter(e), rng);
+	ok = ok && e.size() == 45;
+	e.clear();
+	myrng::util::erdos_renyi_gnp(2000u, 0.01, std::back_inserter(e), rng);
+	for (std::size_t i = 0; i < e.size(); ++i)
+		ok = ok && e[i].second < e[i].first && e[i].first < 2000
+				&& (i == 0 || e[i - 1] < e[i]);
+	// 19990 edges expected, standard deviation 141
+	ok = ok && e.size() > 19000 && e.size() < 21000;
+	check(ok, "util", "erdos_renyi_gnp() gives edges in order");
+}
+
+static void testIncremental()
+{
+	myrng::MT19937 batch, incremental;
+	batch.Seed(5489);
+	incremental.setIncremental(true);
+	incremental.Seed(5489);
+	bool same = true;
+	for (int i = 0; i < 10000; ++i)
+	{
+		if (i == 5000)
+			incremental.setIncremental(false);
+		if (i == 7000)
+			incremental.setIncremental(true);
+		same = same && batch.Uniform01() == incremental.Uniform01();
+	}
+	check(same, "MT19937", "incremental regeneration gives the same sequence");
+
+	std::stringstream buf;
+	incremental.save(buf);
+	batch.load(buf);
+	same = batch.isIncremental();
+	for (int i = 0; i < 1000; ++i)
+		same = same && batch.Uniform01() == incremental.Uniform01();
+	check(same, "MT19937", "load() restores the regeneration mode");
+
+	// set the position in the state, stored after the tag and the seed, to
+	// 0x80000000
+	std::string state = buf.str();
+	const std::size_t pos = 1 + std::strlen(batch.getName()) + 8;
+	state[pos] = state[pos + 1] = state[pos + 2] = 0;
+	state[pos + 3] = '\x80';
+	std::istringstream corrupt(state);
+	double before = myrng::MT19937(batch).Uniform01();
+	check(!batch.load(corrupt) && batch.Uniform01() == before, "MT19937",
+			"load() rejects a position beyond the state");
+}
+
+/// Block generation with fill() equals repeated calls, also through AnyRNG
+template<class RNG>
+static void testFill()
+{
+	typedef typename RNG::result_type word;
+	RNG filled, scalar;
+	filled.Seed(6);
+	scalar.Seed(6);
+	const char* name = scalar.getName();
+	std::vector<word> out(1500);
+	bool same = true;
+	for (int i = 0; i < 40; ++i)
+	{
+		if (i == 20)
+		{
+			filled.setIncremental(true);
+			scalar.setIncremental(true);
+		}
+		const std::size_t n = i * 37 % out.size() + 1;
+		filled.fill(&out[0], n);
+		for (std::size_t k = 0; k < n; ++k)
+			same = same && out[k] == scalar();
+	}
+	check(same, name, "fill() equals repeated calls");
+
+	myrng::AnyRNG any;
+	same = any.select(name);
+	any.Seed(7);
+	scalar.Seed(7);
+	for (int i = 0; i < 5000; ++i)
+	{
+		const uint64_t y = scalar();
+		same = same && any() == (y & 0xffffffffU);
+		if (sizeof(word) == 8)
+			same = same && any() == y >> 32;
+	}
+	check(same, name, "AnyEngine fills its buffer with the same numbers");
+}
+
+/// Streams of an arena do not depend on the order in which they are used
+static void testStreamArena()
+{
+	// published output of xoshiro128** from the state 1, 2, 3, 4
+	static const uint32_t reference[4] =
+	{ 11520, 0, 5927040, 70819200 };
+	uint32_t s[4] =
+	{ 1, 2, 3, 4 };
+	bool same = true;
+	for (int i = 0; i < 4; ++i)
+		same = same && myrng::Xoshiro128Engine::step(s) == reference[i];
+	check(same, "xoshiro128**", "matches the reference sequence");
+
+	const std::size_t n = 1000;
+	myrng::StreamArena forward(n, 50), backward(n, 50);
+	std::vector<double> a(3 * n), b(3 * n);
+	for (int round = 0; round < 3; ++round)
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			myrng::StreamRNG rng = forward[i];
+			a[round * n + i] = rng.Normal01Polar();
+			myrng::StreamRNG other = backward[n - 1 - i];
+			b[round * n + n - 1 - i] = other.Normal01Polar();
+		}
+	same = a == b && a[0] != a[1];
+	myrng::Xoshiro128 single;
+	single.Seed(50);
+	same = same && single.Normal01Polar() == a[0];
+	check(same, "StreamArena", "streams do not depend on the update order");
+
+	forward.resize(2 * n);
+	backward.reset(5);
+	myrng::StreamArena fresh(2 * n, 50);
+	same = forward.size() == 2 * n
+			&& forward[n + 7].Uniform01() == fresh[n + 7].Uniform01()
+			&& backward[5].Normal01Polar() == a[5];
+	forward[9].Seed(51);
+	myrng::StreamArena other(10, 51);
+	same = same && forward[9].Uniform01() == other[9].Uniform01();
+	check(same, "StreamArena", "resize() and reset() start new streams");
+
+	std::stringstream buf;
+	forward.save(buf);
+	std::vector<double> expected(2 * n);
+	for (std::size_t i = 0; i < 2 * n; ++i)
+		expected[i] = forward[i].Uniform01();
+	myrng::StreamArena restored(3, 1);
+	same = static_cast<bool>(restored.load(buf))
+			&& restored.size() == 2 * n && restored.getSeed() == 50;
+	for (std::size_t i = 0; i < 2 * n; ++i)
+		same = same && restored[i].Uniform01() == expected[i];
+	std::stringstream stream;
+	myrng::StreamRNG view = restored[3];
+	view.save(stream);
+	const double next = view.Uniform01();
+	same = same && restored[4].load(stream) && restored[4].Uniform01() == next;
+	check(same, "StreamArena", "load() restores all streams");
+
+	// raise the stored number of streams to 2^62 + 2n, whose size in words
+	// overflows, and to 2^56 + 2n, which exceeds the data
+	std::string state = buf.str();
+	const std::size_t pos = 1 + std::strlen("StreamArena") + 8 + 7;
+	same = true;
+	for (int top = 0x40; top > 0; top >>= 6)
+	{
+		state[pos] = static_cast<char>(top);
+		std::istringstream in(state);
+		same = same && !restored.load(in) && restored.size() == 2 * n;
+	}
+	check(same, "StreamArena", "load() rejects a corrupt number of streams");
+}
+
+/// Sobol points agree with the reference, with seek() and after load()
+static void testSobol(myrng::SobolEngine::Scrambling mode, const char* name)
+{
+	const std::size_t d = 20;
+	myrng::Sobol qrng(d), other(d);
+	qrng.setScrambling(mode);
+	other.setScrambling(mode);
+	qrng.Seed(17);
+	other.Seed(17);
+	if (mode == myrng::SobolEngine::NONE)
+	{
+		// first points of dimensions 1 to 4 in units of 1/8
+		static const unsigned int reference[8][4] =
+		{
+		{ 0, 0, 0, 0 },
+		{ 4, 4, 4, 4 },
+		{ 6, 2, 2, 2 },
+		{ 2, 6, 6, 6 },
+		{ 3, 3, 5, 7 },
+		{ 7, 7, 1, 3 },
+		{ 5, 1, 7, 5 },
+		{ 1, 5, 3, 1 } };
+		bool same = true;
+		for (int i = 0; i < 8; ++i)
+		{
+			const uint32_t* x = qrng.next();
+			for (int j = 0; j < 4; ++j)
+				same = same && x[j] == reference[i][j] << 29;
+		}
+		check(same, name, "points agree with the Joe-Kuo reference");
+		qrng.seek(0);
+	}
+
+	bool same = true;
+	std::vector<int> count(d * 1024);
+	for (int i = 0; i < 5000; ++i)
+	{
+		const uint32_t* x = qrng.next();
+		other.seek(i);
+		const uint32_t* y = other.next();
+		for (std::size_t j = 0; j < d; ++j)
+		{
+			same = same && x[j] == y[j];
+			if (i < 1024)
+				++count[j * 1024 + (x[j] >> 22)];
+		}
+	}
+	check(same, name, "seek() gives the same points as next()");
+	check(std::count(count.begin(), count.end(), 1) == int(count.size()), name,
+			"the first 2^10 points are stratified in every coordinate");
+
+	std::stringstream buf;
+	qrng.save(buf);
+	other.setScrambling(myrng::SobolEngine::OWEN);
+	other.Seed(1);
+	same = static_cast<bool>(other.load(buf));
+	std::vector<double> u(d), v(d);
+	for (int i = 0; i < 100; ++i)
+	{
+		qrng.Normal01(&u[0]);
+		other.Normal01(&v[0]);
+		same = same && u == v && std::isfinite(u[0]);
+	}
+	check(same, name, "load() restores scrambling and position");
+}
+
+/// The antithetic stream mirrors uniforms and normals exactly
+template<class Engine>
+static void testAntithetic()
+{
+	myrng::RandomVariates<myrng::AntitheticEngine<Engine> > rng, mirror;
+	rng.Seed(5);
+	mirror.setAntithetic(true);
+	mirror.Seed(5);
+	const char* name = rng.getName();
+	bool same = true;
+	for (int i = 0; i < 10000; ++i)
+	{
+		same = same && rng.Uniform01() + mirror.Uniform01() == 1.;
+		same = same && rng.Normal01Polar() == -mirror.Normal01Polar();
+		same = same && rng.Uniform01_53() + mirror.Uniform01_53() == 1.;
+	}
+	check(same, name, "antithetic run gives 1-U and -Z");
+
+	typename Engine::result_type block[100], mirrored[100];
+	rng.fill(block, 100);
+	mirror.fill(mirrored, 100);
+	same = true;
+	for (int i = 0; i < 100; ++i)
+		same = same && mirrored[i] == static_cast<typename Engine::result_type>(
+				rng.max() - block[i]);
+	check(same, name, "fill() mirrors the numbers");
+
+	std::stringstream buf;
+	mirror.save(buf);
+	rng.load(buf);
+	same = rng.isAntithetic();
+	for (int i = 0; i < 1000; ++i)
+		same = same && rng.Uniform01() == mirror.Uniform01();
+	check(same, name, "load() restores the antithetic mode");
+}
+
+/// Every batch of a Latin hypercube covers all strata of every coordinate
+static void testLatinHypercube()
+{
+	const std::size_t d = 5, n = 1000;
+	myrng::LatinHypercube lhs(d), other(d);
+	lhs.setPoints(n);
+	lhs.Seed(3);
+	std::vector<double> x(d), y(d);
+	bool ok = true;
+	for (int batch = 0; batch < 3; ++batch)
+	{
+		std::vector<int> count(d * n);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			lhs.Uniform01(&x[0]);
+			for (std::size_t j = 0; j < d; ++j)
+				++count[j * n + static_cast<std::size_t>(x[j] * n)];
+		}
+		ok = ok && std::count(count.begin(), count.end(), 1) == int(d * n);
+	}
+	check(ok, "LatinHypercube", "each batch has one point per stratum");
+
+	lhs.Uniform01(&x[0]);
+	std::stringstream buf;
+	lhs.save(buf);
+	ok = static_cast<bool>(other.load(buf)) && other.points() == n;
+	for (std::size_t i = 0; i < 3 * n; ++i)
+	{
+		lhs.Normal01(&x[0]);
+		other.Normal01(&y[0]);
+		ok = ok && x == y;
+	}
+	check(ok, "LatinHypercube", "load() restores the batch");
+
+	// corrupt the stored number of points, 2^32 with the data of 1000
+	// points, and the last stratum, n
+	std::string state = buf.str();
+	const std::size_t pos = state.size() - 4 * d * n - 16;
+	std::string huge = state, stratum = state;
+	huge[pos] = huge[pos + 1] = 0;
+	huge[pos + 4] = 1;
+	stratum.replace(stratum.size() - 4, 4, "\xe8\x03\0\0", 4);
+	other.Normal01(&x[0]);
+	lhs.Normal01(&y[0]);
+	ok = x == y;
+	for (int k = 0; k < 2; ++k)
+	{
+		std::istringstream in(k ? stratum : huge);
+		ok = ok && !other.load(in);
+		other.Normal01(&x[0]);
+		lhs.Normal01(&y[0]);
+		ok = ok && x == y;
+	}
+	check(ok, "LatinHypercube", "load() rejects a corrupt batch unchanged");
+}
+
+/// MultivariateNormal reproduces the covariance, also of singular matrices
+static void testMultivariateNormal()
+{
+	static const double C[9] =
+	{ 4., 1.2, -0.6, 1.2, 1., 0.3, -0.6, 0.3, 2. };
+	static const double mean[3] =
+	{ 1., 2., 3. };
+	myrng::MultivariateNormal mvn;
+	bool ok = mvn.setCovariance(C, 3) && mvn.isCholesky();
+	mvn.setMean(mean);
+	myrng::WELL1024a batch, scalar;
+	batch.Seed(3);
+	scalar.Seed(3);
+	const std::size_t n = 100000;
+	std::vector<double> x(3 * n);
+	mvn(batch, &x[0], n);
+	for (std::size_t i = 0; i < 1000; ++i)
+	{
+		double v[3];
+		mvn(scalar, v);
+		for (int k = 0; k < 3; ++k)
+			ok = ok && std::fabs(v[k] - x[k * n + i]) < 1e-12;
+	}
+	check(ok, "MultivariateNormal", "batch equals repeated single vectors");
+
+	double cov[9] = { 0. };
+	for (std::size_t i = 0; i < n; ++i)
+		for (int a = 0; a < 3; ++a)
+			for (int b = 0; b < 3; ++b)
+				cov[3 * a + b] += (x[a * n + i] - mean[a])
+						* (x[b * n + i] - mean[b]) / n;
+	ok = true;
+	for (int k = 0; k < 9; ++k)
+		ok = ok && std::fabs(cov[k] - C[k]) < 0.05;
+	check(ok, "MultivariateNormal", "sample covariance matches");
+
+	// rank 2: the first two components are identical
+	static const double S[9] =
+	{ 1., 1., 0., 1., 1., 0., 0., 0., 2. };
+	ok = mvn.setCovariance(S, 3) && !mvn.isCholesky();
+	const std::vector<double>& A = mvn.factor();
+	for (int a = 0; a < 3; ++a)
+		for (int b = 0; b < 3; ++b)
+		{
+			double s = 0.;
+			for (int k = 0; k < 3; ++k)
+				s += A[3 * a + k] * A[3 * b + k];
+			ok = ok && std::fabs(s - S[3 * a + b]) < 1e-12;
+		}
+	static const double indefinite[4] =
+	{ 1., 2., 2., 1. };
+	ok = ok && !mvn.setCovariance(indefinite, 2) && mvn.dimension() == 3;
+	check(ok, "MultivariateNormal",
+			"eigendecomposition handles singular matrices");
+}
+
+/// Multinomial counts add up, Dirichlet proportions survive tiny shapes
+template<class RNG>
+static void testMultinomial()
+{
+	RNG rng;
+	rng.Seed(47);
+	const char* name = rng.getName();
+	static const double p[5] =
+	{ 0.5, 0., 0.25, 1e-9, 0.25 };
+	bool ok = true;
+	for (int i = 0; i < 1000; ++i)
+	{
+		unsigned long k[5];
+		const unsigned long n = i % 2 ? 1000000000UL : i;
+		rng.Multinomial(n, p, 5, k);
+		ok = ok && k[0] + k[1] + k[2] + k[3] + k[4] == n && k[1] == 0;
+	}
+	check(ok, name, "Multinomial() counts sum to n");
+
+	// 1 - 0.01 - 0.41 - 0.58 is 1.1e-16 in doubles, which must not reach the
+	// last category
+	static const double q[4] =
+	{ 0.01, 0.41, 0.58, 0. };
+	unsigned long long m[4];
+	rng.Multinomial(1000000000000000000ULL, q, 4, m);
+	check(m[3] == 0 && m[0] + m[1] + m[2] == 1000000000000000000ULL, name,
+			"Multinomial() leaves zero probabilities empty");
+
+	static const double alpha[4] =
+	{ 1e-3, 1e-3, 0.5, 20. };
+	ok = true;
+	for (int i = 0; i < 1000; ++i)
+	{
+		double x[4];
+		rng.Dirichlet(alpha, 4, x);
+		const double sum = x[0] + x[1] + x[2] + x[3];
+		for (int k = 0; k < 4; ++k)
+			ok = ok && x[k] >= 0. && x[k] <= 1.;
+		ok = ok && std::fabs(sum - 1.) < 1e-12;
+	}
+	check(ok, name, "Dirichlet() proportions sum to 1");
+}
+
+int main()
+{
+	std::cout << "  Testing engine interfaces --------------------------\n";
+	testCheckpoint<myrng::WELL1024a, myrng::MT19937>();
+	testCheckpoint<myrng::MT19937, myrng::WELL1024a>();
+	testCheckpoint<myrng::WELL512a, myrng::WELL1024a>();
+	testCheckpoint<myrng::WELL19937a, myrng::MT19937>();
+	testCheckpoint<myrng::WELL44497a, myrng::WELL19937a>();
+	testCheckpoint<myrng::MT11213, myrng::MT19937>();
+	testCheckpoint<myrng::MT19937_64, myrng::MT19937>();
+	testCheckpoint<myrng::Xoshiro128, myrng::WELL1024a>();
+	testReference<myrng::MT19937, std::mt19937>();
+	testReference<myrng::MT11213,
+			std::mersenne_twister_engine<uint_fast32_t, 32, 351, 175, 19,
+					0xccab8ee7, 11, 0xffffffff, 7, 0x31b6ab00, 15, 0xffe50000,
+					17, 1812433253> >();
+	testReference<myrng::MT19937_64, std::mt19937_64>();
+	testStandard<myrng::WELL1024a>();
+	testStandard<myrng::MT19937>();
+	testStandard<myrng::MT19937_64>();
+	testFloat<myrng::WELL1024a>();
+	testFloat<myrng::MT19937_64>();
+	testBits<myrng::WELL1024a>();
+	testBits<myrng::MT19937_64>();
+	testChances<myrng::WELL1024a>();
+	testChances<myrng::MT19937_64>();
+	testChances<myrng::AnyRNG>();
+	testEnsemble<myrng::WELL1024aParams, 16>();
+	testEnsemble<myrng::WELL19937aParams, 5>();
+	testRecordReplay<myrng::WELLEngine, myrng::MTEngine>();
+	testRecordReplay<myrng::MTEngine, myrng::WELLEngine>();
+	testBuffered<myrng::WELLEngine>();
+	testBuffered<myrng::MTEngine>();
+	testAny<myrng::WELL1024a>();
+	testAny<myrng::WELL44497a>();
+	testAny<myrng::MT19937>();
+	testAny<myrng::MT11213>();
+	testJump<myrng::WELL1024a>();
+	testJump<myrng::WELL19937a>();
+	testJump<myrng::MT19937>();
+	testJump<myrng::MT19937_64>();
+	testResolution<myrng::WELL1024a>();
+	testResolution<myrng::MT19937_64>();
+	testVectors<myrng::WELL1024a>();
+	testVectors<myrng::MT19937>();
+	testSobol(myrng::SobolEngine::NONE, "Sobol");
+	testSobol(myrng::SobolEngine::LINEAR, "Sobol linear");
+	testSobol(myrng::SobolEngine::OWEN, "Sobol Owen");
+	testAntithetic<myrng::WELLEngine>();
+	testAntithetic<myrng::MT19937_64Engine>();
+	testLatinHypercube();
+	testMultivariateNormal();
+	testMultinomial<myrng::WELL1024a>();
+	testMultinomial<myrng::MT19937_64>();
+	testStreamArena();
+	testGraphs();
+	testIncremental();
+	testFill<myrng::MT19937>();
+	testFill<myrng::MT11213>();
+	testFill<myrng::MT19937_64>();
+	testStats();
+
+	std::cout << (failed ? "FAILED\n" : "PASSED\n");
+	return failed ? 1 : 0;
+}
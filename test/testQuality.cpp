@@ -0,0 +1,54 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  testQuality.cpp
+ *    Description:  Statistical quality battery for all engines and
+ *                  distributions. Returns a non-zero exit status if any
+ *                  p-value falls below the significance level.
+ *
+ *                  Usage: testQuality [-n samples] [-t threads]
+ *                                     [-a alpha] [-s seed]
+ *
+ * ==========================================================================
+ */
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <myrng.h>
+#include <XoshiroEngine.h>
+#include "QualityTests.h"
+
+int main(int argc, char *argv[])
+{
+	quality::Options opt;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!std::strcmp(argv[i], "-n"))
+			opt.samples = static_cast<quality::count_t>(std::strtod(argv[i + 1], 0));
+		else if (!std::strcmp(argv[i], "-t"))
+			opt.threads = std::atoi(argv[i + 1]);
+		else if (!std::strcmp(argv[i], "-a"))
+			opt.alpha = std::strtod(argv[i + 1], 0);
+		else if (!std::strcmp(argv[i], "-s"))
+			opt.seed = std::strtoul(argv[i + 1], 0, 0);
+		else
+		{
+			std::cerr << "Usage: " << argv[0]
+					<< " [-n samples] [-t threads] [-a alpha] [-s seed]\n";
+			return 2;
+		}
+	}
+
+	unsigned failed = 0;
+	failed += QualityTests<myrng::WELL1024a>(opt).run();
+	failed += QualityTests<myrng::MT19937>(opt).run();
+	failed += QualityTests<myrng::WELL512a>(opt).run();
+	failed += QualityTests<myrng::WELL19937a>(opt).run();
+	failed += QualityTests<myrng::WELL44497a>(opt).run();
+	failed += QualityTests<myrng::MT11213>(opt).run();
+	failed += QualityTests<myrng::MT19937_64>(opt).run();
+	failed += QualityTests<myrng::Xoshiro128>(opt).run();
+
+	std::cout << (failed ? "FAILED\n" : "PASSED\n");
+	return failed ? 1 : 0;
+}